@@ -0,0 +1,224 @@
+/**
+ * eigen_string_benchmark.cc
+ *
+ * Copyright 2026. All Rights Reserved.
+ *
+ * Created: October 17, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#include <algorithm>  // std::min
+#include <chrono>     // std::chrono
+#include <cmath>      // std::round
+#include <cstdlib>    // std::atoi
+#include <iostream>   // std::cout
+#include <limits>     // std::numeric_limits
+#include <sstream>    // std::stringstream
+#include <stdexcept>  // std::invalid_argument
+#include <string>     // std::string
+#include <typeinfo>   // typeid
+
+#if __has_include(<charconv>)
+#include <charconv>  // std::from_chars
+#endif  // __has_include(<charconv>)
+
+#include "ctrl_utils/eigen_string.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Returns the fastest time of fn in milliseconds.
+ */
+template <typename Fn>
+double BestMs(size_t num_iterations, Fn&& fn) {
+  double best = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < num_iterations; i++) {
+    const Clock::time_point t_start = Clock::now();
+    fn();
+    const std::chrono::duration<double, std::milli> elapsed =
+        Clock::now() - t_start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+/**
+ * DecodeMatlab() as it was before the fast parser (commit 35ebfe9), as the
+ * baseline for the speedup.
+ */
+template <typename Derived>
+Derived BaselineDecodeMatlab(const std::string& str) {
+  std::string str_local = str;
+
+  // Create matrix to return
+  Derived matrix;
+  size_t num_cols = matrix.cols();
+  size_t num_rows = matrix.rows();
+  typename Derived::Scalar eof;  // Used to check for eof and print Matrix scalar type
+
+  // Count number of columns
+  size_t idx_col_end = 0;
+  if (num_cols == 0 || (num_cols == 1 && num_rows == 0)) {
+    num_cols = 0;
+    size_t idx = 0;
+    idx_col_end = str.find_first_of(';');
+    while (idx < idx_col_end) {
+      // Skip over extra whitespace
+      idx = str.find_first_not_of(' ', idx);
+      if (idx >= idx_col_end) break;
+
+      // Find next delimiter
+      if (str[idx] == ';') break;
+      idx = str.find_first_of(' ', idx + 1);
+      ++num_cols;
+    }
+  }
+
+  // Count number of rows
+  if (num_rows == 0) {
+    size_t idx = idx_col_end;
+    if (idx_col_end != 0) {  // First row already traversed
+      idx = idx_col_end;
+      num_rows = 1;
+    }
+    while (idx != std::string::npos) {
+      // Clear semicolons as we go
+      if (idx != 0) str_local[idx] = ' ';
+
+      // Find next delimiter
+      idx = str.find_first_of(';', idx + 1);
+      ++num_rows;
+    }
+    // Ignore trailing semicolon
+    idx = str.find_last_not_of(' ');
+    if (str[idx] == ';') --num_rows;
+  } else {
+    // Clear remaining semicolons
+    for (size_t idx = idx_col_end; idx < str.size(); idx++) {
+      if (str[idx] == ';') str_local[idx] = ' ';
+    }
+  }
+
+  // Check number of rows and columns
+  if (num_cols == 0)
+    throw std::invalid_argument(
+        "DecodeMatlab(): Failed to decode Eigen::MatrixX" +
+        std::string(typeid(eof).name()) + "(" + std::to_string(num_rows) +
+        ", " + std::to_string(num_cols) + ") from: (" + str + ").");
+  if (num_rows == 1) {
+    // Convert to vector
+    num_rows = num_cols;
+    num_cols = 1;
+  }
+  if (matrix.rows() == 0 || matrix.cols() == 0) {
+    matrix.resize(num_rows, num_cols);
+  }
+
+  // Parse matrix
+  std::stringstream ss(str_local);
+  for (size_t i = 0; i < num_rows; ++i) {
+    for (size_t j = 0; j < num_cols; ++j) {
+      ss >> matrix(i,j);
+      if (ss.fail()) {
+        throw std::invalid_argument(
+            "DecodeMatlab(): Failed to decode Eigen::MatrixX" +
+            std::string(typeid(eof).name()) + "(" + std::to_string(num_rows) +
+            ", " + std::to_string(num_cols) + ") from: (" + str + ").");
+      }
+    }
+  }
+
+  // Make sure there are no numbers left
+  ss >> eof;
+  if (!ss.fail()) {
+    throw std::invalid_argument(
+        "DecodeMatlab(): Failed to decode Eigen::MatrixX" +
+        std::string(typeid(eof).name()) + "(" + std::to_string(num_rows) +
+        ", " + std::to_string(num_cols) + ") from: (" + str + ").");
+  }
+
+  return matrix;
+}
+
+#ifdef __cpp_lib_to_chars
+/**
+ * Parses the whitespace-separated doubles with std::from_chars, as a lower
+ * bound for a decoder built on it.
+ */
+double SumFromChars(const std::string& str) {
+  double sum = 0.;
+  const char* it = str.data();
+  const char* end = str.data() + str.size();
+  while (it != end) {
+    if (*it == ' ' || *it == ';') {
+      ++it;
+      continue;
+    }
+    double value;
+    it = std::from_chars(it, end, value).ptr;
+    sum += value;
+  }
+  return sum;
+}
+#endif  // __cpp_lib_to_chars
+
+void Run(const std::string& name, const Eigen::MatrixXd& A,
+         size_t num_iterations) {
+  const std::string str_matlab = ctrl_utils::EncodeMatlab(A);
+  const std::string str_json = ctrl_utils::EncodeJson(A);
+
+  Eigen::MatrixXd B;
+  const double ms_baseline = BestMs(num_iterations, [&]() {
+    B = BaselineDecodeMatlab<Eigen::MatrixXd>(str_matlab);
+  });
+  const bool is_baseline_exact = B == A;
+  const double ms_matlab = BestMs(num_iterations, [&]() {
+    ctrl_utils::DecodeMatlab(str_matlab, B);
+  });
+  const bool is_matlab_exact = B == A;
+  const double ms_json = BestMs(num_iterations, [&]() {
+    ctrl_utils::DecodeJson(str_json, B);
+  });
+  const bool is_json_exact = B == A;
+
+  std::cout << name << ": " << A.size() << " values, "
+            << str_matlab.size() / A.size() << " bytes per value" << std::endl
+            << "  baseline:     " << ms_baseline << " ms"
+            << (is_baseline_exact ? "" : " (MISMATCH)") << std::endl
+            << "  DecodeMatlab: " << ms_matlab << " ms"
+            << (is_matlab_exact ? "" : " (MISMATCH)") << std::endl
+            << "  DecodeJson:   " << ms_json << " ms"
+            << (is_json_exact ? "" : " (MISMATCH)") << std::endl;
+#ifdef __cpp_lib_to_chars
+  double sum = 0.;
+  const double ms_from_chars = BestMs(num_iterations, [&]() {
+    sum = SumFromChars(str_matlab);
+  });
+  std::cout << "  from_chars:   " << ms_from_chars << " ms (sum " << sum
+            << ")" << std::endl;
+#endif  // __cpp_lib_to_chars
+}
+
+}  // namespace
+
+/**
+ * Times decoding of a large text-encoded matrix with short decimal values,
+ * which take the fast path, and with full-precision values, which take the
+ * general parser, against the stringstream-based baseline parser.
+ *
+ * Usage: eigen_string_benchmark [num_rows] [num_iterations]
+ */
+int main(int argc, char* argv[]) {
+  const int num_rows = argc > 1 ? std::atoi(argv[1]) : 1000;
+  const size_t num_iterations = argc > 2 ? std::atoi(argv[2]) : 5;
+
+  Eigen::MatrixXd A = Eigen::MatrixXd::Random(num_rows, num_rows);
+  Run("full precision", A, num_iterations);
+
+  // Round to 6 decimals, as sensor values usually are.
+  A = A.unaryExpr([](double x) { return std::round(x * 1e6) / 1e6; });
+  Run("6 decimals", A, num_iterations);
+  return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * mget_benchmark.cc
+ *
+ * Copyright 2026. All Rights Reserved.
+ *
+ * Created: October 17, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#include <atomic>     // std::atomic
+#include <cstdlib>    // std::atoi, std::malloc, std::free
+#include <iostream>   // std::cout
+#include <new>        // std::bad_alloc
+#include <string>     // std::string, std::to_string
+#include <vector>     // std::vector
+
+#include <Eigen/Core>
+
+#include "ctrl_utils/redis_client.h"
+#include "ctrl_utils/redis_server.h"
+
+namespace {
+
+std::atomic<size_t> g_num_allocations{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace {
+
+/**
+ * Returns the average number of heap allocations per call of fn.
+ */
+template <typename Fn>
+double CountAllocations(size_t num_iterations, Fn&& fn) {
+  fn();  // Warm up buffers.
+  const size_t num_start = g_num_allocations.load();
+  for (size_t i = 0; i < num_iterations; i++) fn();
+  return static_cast<double>(g_num_allocations.load() - num_start) /
+         num_iterations;
+}
+
+/**
+ * Counts the heap allocations per MGET call of fixed-size Eigen matrices,
+ * including those made by cpp_redis to queue and send the command.
+ */
+template <typename T>
+void Run(const std::string& name, ctrl_utils::RedisClient& redis_client,
+         const std::vector<std::string>& keys, size_t num_iterations) {
+  for (const std::string& key : keys) {
+    redis_client.set(key, T::Random().eval());
+  }
+  redis_client.sync_commit();
+
+  const double num_vector = CountAllocations(num_iterations, [&]() {
+    std::future<std::vector<T>> values = redis_client.mget<T>(keys);
+    redis_client.commit();
+    values.get();
+  });
+
+  std::vector<T> values(keys.size());
+  const double num_in_place = CountAllocations(num_iterations, [&]() {
+    std::future<void> fut_values = redis_client.mget(keys, values.data());
+    redis_client.commit();
+    fut_values.get();
+  });
+
+  std::cout << name << ", " << keys.size() << " keys, allocations per call"
+            << std::endl
+            << "  mget<T>(keys):         " << num_vector << std::endl
+            << "  mget(keys, values):    " << num_in_place << std::endl;
+}
+
+}  // namespace
+
+/**
+ * Compares the heap allocations of mget<T>(keys) and mget(keys, values) with
+ * the tensor codec. Decoding into values allocates nothing, so the remaining
+ * allocations of mget(keys, values) come from building, queueing and sending
+ * the command and from the reply.
+ *
+ * Usage: mget_benchmark [num_keys] [num_iterations]
+ */
+int main(int argc, char* argv[]) {
+  const size_t num_keys = argc > 1 ? std::atoi(argv[1]) : 16;
+  const size_t num_iterations = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+  ctrl_utils::RedisServer redis_server;
+  ctrl_utils::RedisClient redis_client;
+  redis_client.connect("127.0.0.1", redis_server.port());
+  redis_client.set_codec(ctrl_utils::RedisClient::Codec::kTensor);
+
+  // Keys longer than the small-string buffer allocate when copied.
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < num_keys; i++) {
+    keys.push_back("benchmark::mget::key" + std::to_string(i));
+  }
+
+  Run<Eigen::Vector3d>("Eigen::Vector3d", redis_client, keys, num_iterations);
+  Run<Eigen::Matrix4d>("Eigen::Matrix4d", redis_client, keys, num_iterations);
+  return 0;
+}
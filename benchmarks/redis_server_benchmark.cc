@@ -0,0 +1,108 @@
+/**
+ * redis_server_benchmark.cc
+ *
+ * Copyright 2026. All Rights Reserved.
+ *
+ * Created: October 17, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#include <chrono>     // std::chrono
+#include <cstdlib>    // std::atoi
+#include <future>     // std::promise
+#include <iostream>   // std::cout
+#include <stdexcept>  // std::runtime_error
+#include <string>     // std::string, std::to_string
+#include <vector>     // std::vector
+
+#include "ctrl_utils/redis_client.h"
+#include "ctrl_utils/redis_server.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ElapsedUs(Clock::time_point t_start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - t_start)
+      .count();
+}
+
+}  // namespace
+
+/**
+ * Compares synchronous and pipelined GETs against a server with a simulated
+ * network round trip, and checks that a TYPE-filtered SCAN returns only keys
+ * of that type.
+ *
+ * Usage: redis_server_benchmark [num_keys] [latency_us]
+ */
+int main(int argc, char* argv[]) {
+  const size_t num_keys = argc > 1 ? std::atoi(argv[1]) : 100;
+  const std::chrono::microseconds latency(argc > 2 ? std::atoi(argv[2]) : 200);
+
+  ctrl_utils::RedisServer redis_server(0, latency);
+  ctrl_utils::RedisClient redis_client;
+  redis_client.connect("127.0.0.1", redis_server.port());
+
+  std::vector<std::string> keys;
+  keys.reserve(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    keys.push_back("benchmark::key" + std::to_string(i));
+    redis_client.set(keys.back(), static_cast<double>(i));
+    redis_client.hset("benchmark::hash" + std::to_string(i), "field", "1");
+  }
+  redis_client.sync_commit();
+
+  // One round trip per key.
+  Clock::time_point t_start = Clock::now();
+  double sum_sync = 0.;
+  for (const std::string& key : keys) {
+    sum_sync += redis_client.sync_get<double>(key);
+  }
+  const double us_sync = ElapsedUs(t_start);
+
+  // One round trip for all keys.
+  t_start = Clock::now();
+  std::vector<double> values(num_keys);
+  for (size_t i = 0; i < num_keys; i++) redis_client.get(keys[i], values[i]);
+  redis_client.sync_commit();
+  double sum_pipelined = 0.;
+  for (double value : values) sum_pipelined += value;
+  const double us_pipelined = ElapsedUs(t_start);
+
+  // Scan in small batches while filtering by type.
+  t_start = Clock::now();
+  size_t num_scanned = 0;
+  size_t num_batches = 0;
+  std::promise<void> promise_scan;
+  redis_client.scan(
+      "benchmark::*", 10, "string",
+      [&num_scanned, &num_batches](std::vector<std::string>&& batch) {
+        for (const std::string& key : batch) {
+          if (key.find("benchmark::key") != 0) {
+            throw std::runtime_error("SCAN TYPE returned " + key + ".");
+          }
+        }
+        num_scanned += batch.size();
+        num_batches++;
+      },
+      [&promise_scan]() { promise_scan.set_value(); });
+  redis_client.commit();
+  promise_scan.get_future().wait();
+  const double us_scan = ElapsedUs(t_start);
+
+  if (sum_sync != sum_pipelined || num_scanned != num_keys) {
+    std::cout << "Mismatch: sum_sync=" << sum_sync
+              << " sum_pipelined=" << sum_pipelined
+              << " num_scanned=" << num_scanned << std::endl;
+    return 1;
+  }
+
+  std::cout << num_keys << " keys, " << latency.count() << " us latency"
+            << std::endl
+            << "  sync_get:      " << us_sync << " us" << std::endl
+            << "  pipelined get: " << us_pipelined << " us" << std::endl
+            << "  scan (TYPE string, COUNT 10): " << us_scan << " us in "
+            << num_batches << " batches" << std::endl;
+  return 0;
+}
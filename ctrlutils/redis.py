@@ -169,6 +169,13 @@ def decode_tensor(b: bytes) -> np.ndarray:
     return tensor
 
 
+def decode_matrix(b: Union[str, bytes]) -> np.ndarray:
+    """Decodes an Eigen matrix in either Matlab or tensor format."""
+    if isinstance(b, bytes) and b.startswith(b"( "):
+        return decode_tensor(b)
+    return decode_matlab(b)
+
+
 def encode_tensor(tensor: np.ndarray) -> bytes:
     ss = OutputStringStream()
     shape = " ".join(map(str, tensor.shape))
@@ -212,7 +219,7 @@ class RedisClient(redis.Redis):
     def get_matrix(self, key: str) -> np.ndarray:
         """Gets an Eigen::Matrix or Eigen::Vector from Redis."""
         b_val = self.get(key)
-        return decode_matlab(b_val)
+        return decode_matrix(b_val)
 
     def set_matrix(self, key: str, val: np.ndarray) -> bool:
         """Sets an Eigen::Matrix or Eigen::Vector in Redis."""
@@ -256,7 +263,7 @@ class Pipeline(redis.client.Pipeline):
     def get_matrix(self, key: str) -> "Pipeline":
         """Gets an Eigen::Matrix or Eigen::Vector from Redis."""
         super().get(key)
-        self._decode_fns.append(decode_matlab)
+        self._decode_fns.append(decode_matrix)
         return self
 
     def set_matrix(self, key: str, val: np.ndarray) -> "Pipeline":
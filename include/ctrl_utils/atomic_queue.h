@@ -86,7 +86,11 @@ class AtomicQueue {
    * All currently waiting threads will receive an empty-initialized T.
    */
   void Terminate() {
-    terminate_ = true;
+    {
+      // Lock so that a thread about to wait cannot miss the notification.
+      std::unique_lock<std::mutex> lock(m_);
+      terminate_ = true;
+    }
     cv_.notify_all();
   }
 
@@ -172,7 +176,11 @@ class AtomicBuffer {
    * All currently waiting threads will receive an empty-initialized T.
    */
   void Terminate() {
-    terminate_ = true;
+    {
+      // Lock so that a thread about to wait cannot miss the notification.
+      std::unique_lock<std::mutex> lock(m_);
+      terminate_ = true;
+    }
     cv_.notify_all();
   }
 
@@ -0,0 +1,253 @@
+/**
+ * compression.h
+ *
+ * Copyright 2026. All Rights Reserved.
+ *
+ * Created: October 17, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef CTRL_UTILS_COMPRESSION_H_
+#define CTRL_UTILS_COMPRESSION_H_
+
+#include <algorithm>  // std::copy, std::min
+#include <cstdint>    // uint64_t
+#include <limits>     // std::numeric_limits
+#include <stdexcept>  // std::invalid_argument, std::runtime_error
+#include <string>     // std::string
+
+#ifdef CTRL_UTILS_WITH_LZ4
+#include <lz4.h>
+#endif  // CTRL_UTILS_WITH_LZ4
+
+#ifdef CTRL_UTILS_WITH_ZSTD
+#include <zstd.h>
+#endif  // CTRL_UTILS_WITH_ZSTD
+
+namespace ctrl_utils {
+
+/**
+ * Compression algorithms for string values.
+ *
+ * LZ4 and zstd are compiled in when CTRL_UTILS_WITH_LZ4 and
+ * CTRL_UTILS_WITH_ZSTD are defined, which the CMake options
+ * CTRL_UTILS_WITH_LZ4 and CTRL_UTILS_WITH_ZSTD do along with linking the
+ * libraries.
+ */
+enum class Compression {
+  kNone,
+  /// Fast compression suited for high-rate data.
+  kLz4,
+  /// Higher compression ratio at a moderate speed.
+  kZstd,
+};
+
+/**
+ * Returns whether the compression algorithm is compiled in.
+ */
+constexpr bool IsCompressionAvailable(Compression compression) {
+  switch (compression) {
+    case Compression::kNone:
+      return true;
+    case Compression::kLz4:
+#ifdef CTRL_UTILS_WITH_LZ4
+      return true;
+#else   // CTRL_UTILS_WITH_LZ4
+      return false;
+#endif  // CTRL_UTILS_WITH_LZ4
+    case Compression::kZstd:
+#ifdef CTRL_UTILS_WITH_ZSTD
+      return true;
+#else   // CTRL_UTILS_WITH_ZSTD
+      return false;
+#endif  // CTRL_UTILS_WITH_ZSTD
+  }
+  return false;
+}
+
+namespace compression_internal {
+
+// Compressed strings start with "\0cz", one byte for the algorithm, and the
+// uncompressed size as a little-endian uint64. The leading null byte keeps
+// them from colliding with Matlab and tensor strings.
+constexpr char kMagic[] = {'\0', 'c', 'z'};
+constexpr size_t kHeaderSize = sizeof(kMagic) + 1 + sizeof(uint64_t);
+
+inline char AlgorithmByte(Compression compression) {
+  return compression == Compression::kLz4 ? '4' : 'z';
+}
+
+inline Compression AlgorithmFromByte(char algorithm) {
+  if (algorithm == AlgorithmByte(Compression::kLz4)) return Compression::kLz4;
+  if (algorithm == AlgorithmByte(Compression::kZstd)) return Compression::kZstd;
+  return Compression::kNone;
+}
+
+/**
+ * Returns the largest size a payload can decompress to, which bounds the
+ * untrusted size in the header before any memory is allocated for it.
+ *
+ * An LZ4 sequence expands at most 255 times, and the LZ4 API takes int sizes.
+ * The densest zstd block is a 4-byte RLE block of 128 KiB.
+ */
+inline uint64_t MaxDecompressedSize(Compression compression,
+                                    size_t payload_size) {
+  constexpr uint64_t kLz4MaxRatio = 255;
+  constexpr uint64_t kZstdMaxRatio = (uint64_t{1} << 17) / 4;
+  constexpr uint64_t kMaxPayloadSize =
+      std::numeric_limits<uint64_t>::max() / kZstdMaxRatio;
+  const uint64_t size = std::min<uint64_t>(payload_size, kMaxPayloadSize);
+  switch (compression) {
+    case Compression::kLz4:
+      return std::min<uint64_t>(kLz4MaxRatio * size,
+                                std::numeric_limits<int>::max());
+    case Compression::kZstd:
+      return kZstdMaxRatio * size;
+    default:
+      return 0;
+  }
+}
+
+}  // namespace compression_internal
+
+/**
+ * Returns whether the string was produced by Compress().
+ */
+inline bool IsCompressedString(const std::string& str) {
+  using namespace compression_internal;
+  return str.size() >= kHeaderSize &&
+         str.compare(0, sizeof(kMagic), kMagic, sizeof(kMagic)) == 0;
+}
+
+/**
+ * Compresses the string into a self-describing format that Decompress()
+ * restores.
+ *
+ * @param str Uncompressed string.
+ * @param compression Compression algorithm.
+ * @param compressed Output compressed string.
+ * @param level Compression level for zstd (ignored for LZ4).
+ * @return False, leaving compressed unspecified, if compression is
+ *         Compression::kNone or would not make the string smaller.
+ */
+inline bool Compress(const std::string& str, Compression compression,
+                     std::string& compressed, int level = 1) {
+  using namespace compression_internal;
+  if (compression == Compression::kNone) return false;
+  if (!IsCompressionAvailable(compression)) {
+    throw std::invalid_argument(
+        "ctrl_utils::Compress(): Compression algorithm is not compiled in.");
+  }
+
+  size_t capacity = 0;
+#ifdef CTRL_UTILS_WITH_LZ4
+  if (compression == Compression::kLz4) {
+    capacity = LZ4_compressBound(static_cast<int>(str.size()));
+  }
+#endif  // CTRL_UTILS_WITH_LZ4
+#ifdef CTRL_UTILS_WITH_ZSTD
+  if (compression == Compression::kZstd) {
+    capacity = ZSTD_compressBound(str.size());
+  }
+#endif  // CTRL_UTILS_WITH_ZSTD
+  compressed.resize(kHeaderSize + capacity);
+
+  char* header = &compressed[0];
+  std::copy(kMagic, kMagic + sizeof(kMagic), header);
+  header[sizeof(kMagic)] = AlgorithmByte(compression);
+  uint64_t size = str.size();
+  for (size_t i = 0; i < sizeof(uint64_t); i++, size >>= 8) {
+    header[sizeof(kMagic) + 1 + i] = static_cast<char>(size & 0xff);
+  }
+
+  char* payload = header + kHeaderSize;
+  size_t payload_size = 0;
+#ifdef CTRL_UTILS_WITH_LZ4
+  if (compression == Compression::kLz4) {
+    const int result =
+        LZ4_compress_default(str.data(), payload, static_cast<int>(str.size()),
+                             static_cast<int>(capacity));
+    if (result <= 0) return false;
+    payload_size = result;
+  }
+#endif  // CTRL_UTILS_WITH_LZ4
+#ifdef CTRL_UTILS_WITH_ZSTD
+  if (compression == Compression::kZstd) {
+    const size_t result =
+        ZSTD_compress(payload, capacity, str.data(), str.size(), level);
+    if (ZSTD_isError(result)) return false;
+    payload_size = result;
+  }
+#endif  // CTRL_UTILS_WITH_ZSTD
+  (void)level;
+  (void)payload;
+
+  if (kHeaderSize + payload_size >= str.size()) return false;
+  compressed.resize(kHeaderSize + payload_size);
+  return true;
+}
+
+/**
+ * Restores a string produced by Compress().
+ *
+ * @param compressed Compressed string.
+ * @param str Output uncompressed string. Its capacity is reused.
+ */
+inline void Decompress(const std::string& compressed, std::string& str) {
+  using namespace compression_internal;
+  if (!IsCompressedString(compressed)) {
+    throw std::invalid_argument(
+        "ctrl_utils::Decompress(): String is not compressed.");
+  }
+
+  const char algorithm = compressed[sizeof(kMagic)];
+  const Compression compression = AlgorithmFromByte(algorithm);
+  if (compression == Compression::kNone ||
+      !IsCompressionAvailable(compression)) {
+    throw std::runtime_error(
+        std::string("ctrl_utils::Decompress(): Compression algorithm '") +
+        algorithm + "' is unknown or not compiled in.");
+  }
+
+  const char* payload = compressed.data() + kHeaderSize;
+  const size_t payload_size = compressed.size() - kHeaderSize;
+  uint64_t size = 0;
+  for (size_t i = sizeof(uint64_t); i > 0; i--) {
+    size = (size << 8) |
+           static_cast<unsigned char>(compressed[sizeof(kMagic) + i]);
+  }
+  if (size > MaxDecompressedSize(compression, payload_size)) {
+    throw std::runtime_error(
+        "ctrl_utils::Decompress(): Uncompressed size " + std::to_string(size) +
+        " exceeds the maximum for a " + std::to_string(payload_size) +
+        "-byte payload.");
+  }
+  str.resize(size);
+
+  bool is_valid = false;
+#ifdef CTRL_UTILS_WITH_LZ4
+  if (algorithm == AlgorithmByte(Compression::kLz4)) {
+    const int result =
+        LZ4_decompress_safe(payload, &str[0], static_cast<int>(payload_size),
+                            static_cast<int>(size));
+    is_valid = result >= 0 && static_cast<uint64_t>(result) == size;
+  }
+#endif  // CTRL_UTILS_WITH_LZ4
+#ifdef CTRL_UTILS_WITH_ZSTD
+  if (algorithm == AlgorithmByte(Compression::kZstd)) {
+    const size_t result = ZSTD_decompress(&str[0], size, payload, payload_size);
+    is_valid = !ZSTD_isError(result) && result == size;
+  }
+#endif  // CTRL_UTILS_WITH_ZSTD
+  (void)payload;
+
+  if (!is_valid) {
+    throw std::runtime_error(
+        std::string("ctrl_utils::Decompress(): Failed to decompress string ") +
+        "with algorithm '" + algorithm + "'.");
+  }
+}
+
+}  // namespace ctrl_utils
+
+#endif  // CTRL_UTILS_COMPRESSION_H_
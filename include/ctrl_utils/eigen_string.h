@@ -10,11 +10,23 @@
 #ifndef CTRL_UTILS_EIGEN_STRING_H_
 #define CTRL_UTILS_EIGEN_STRING_H_
 
-#include <exception>  // std::invalid_argument
-#include <string>     // std::string, std::to_string
-#include <sstream>    // std::stringstream
+#include <algorithm>    // std::copy
+#include <cfloat>       // FLT_EVAL_METHOD
+#include <cstdint>      // std::int8_t, std::uint8_t, ...
+#include <cstring>      // std::memcpy
+#include <exception>    // std::invalid_argument
+#include <limits>       // std::numeric_limits
+#include <stdexcept>    // std::runtime_error
+#include <string>       // std::string, std::to_string
+#include <string_view>  // std::string_view
+#include <sstream>      // std::stringstream
+#include <type_traits>  // std::is_same, std::is_same_v
+#include <utility>      // std::swap
+#include <vector>       // std::vector
+
 
 #include "eigen.h"
+#include "string.h"
 
 namespace ctrl_utils {
 
@@ -26,7 +38,22 @@ namespace ctrl_utils {
  *   Eigen::MatrixXd A = DecodeMatlab<Eigen::MatrixXd>("1 2 3; 4 5 6");
  */
 template<typename Derived>
-Derived DecodeMatlab(const std::string& str);
+Derived DecodeMatlab(std::string_view str);
+
+/**
+ * Decode an Eigen matrix from Matlab format in place.
+ *
+ * The string is parsed in a single pass. Fixed-size matrices are filled in
+ * row-major order directly without allocating, and dynamic matrices are only
+ * resized if their dimensions differ from the string's. A single row decodes
+ * into a column vector unless the matrix has one row at compile time.
+ *
+ * Usage:
+ *   Eigen::Vector3d x;
+ *   DecodeMatlab("1 2 3", x);
+ */
+template<typename Derived>
+void DecodeMatlab(std::string_view str, Eigen::PlainObjectBase<Derived>& matrix);
 
 /**
  * Encode an Eigen matrix to Matlab format:
@@ -38,6 +65,36 @@ Derived DecodeMatlab(const std::string& str);
 template<typename Derived>
 std::string EncodeMatlab(const Eigen::DenseBase<Derived>& matrix);
 
+/**
+ * Encode an Eigen matrix to Matlab format, appending to the string.
+ *
+ * The string reserves MaxEncodeMatlabSize() before writing, so a buffer that
+ * is cleared and reused across calls stops allocating once it has grown.
+ *
+ * Usage:
+ *   buffer.clear();
+ *   EncodeMatlab(x, buffer);
+ */
+template<typename Derived>
+void EncodeMatlab(const Eigen::DenseBase<Derived>& matrix, std::string& str);
+
+/**
+ * Encode an Eigen matrix to Matlab format through an output iterator.
+ *
+ * Usage:
+ *   std::vector<char> buffer(MaxEncodeMatlabSize(x));
+ *   buffer.resize(EncodeMatlab(x, buffer.begin()) - buffer.begin());
+ */
+template<typename Derived, typename OutputIt>
+OutputIt EncodeMatlab(const Eigen::DenseBase<Derived>& matrix, OutputIt out);
+
+/**
+ * Upper bound on the size of the Matlab encoding of an arithmetic matrix,
+ * computed from its dimensions.
+ */
+template<typename Derived>
+size_t MaxEncodeMatlabSize(const Eigen::DenseBase<Derived>& matrix);
+
 /**
  * Decode an Eigen matrix from Json format:
  *
@@ -46,7 +103,19 @@ std::string EncodeMatlab(const Eigen::DenseBase<Derived>& matrix);
  *   Eigen::MatrixXd A = DecodeJson<Eigen::MatrixXd>("[[1, 2, 3], [4, 5, 6]]");
  */
 template<typename Derived>
-Derived DecodeJson(const std::string& str);
+Derived DecodeJson(std::string_view str);
+
+/**
+ * Decode an Eigen matrix from Json format in place, with the same single-pass
+ * parsing and sizing rules as DecodeMatlab(). The string must be one array of
+ * values or one array of row arrays.
+ *
+ * Usage:
+ *   Eigen::MatrixXd A;
+ *   DecodeJson("[[1, 2, 3], [4, 5, 6]]", A);
+ */
+template<typename Derived>
+void DecodeJson(std::string_view str, Eigen::PlainObjectBase<Derived>& matrix);
 
 /**
  * Encode an Eigen matrix to Json format:
@@ -58,6 +127,96 @@ Derived DecodeJson(const std::string& str);
 template<typename Derived>
 std::string EncodeJson(const Eigen::DenseBase<Derived>& matrix);
 
+/**
+ * Encode an Eigen matrix to Json format, appending to the string.
+ *
+ * The string reserves MaxEncodeJsonSize() before writing, so a buffer that is
+ * cleared and reused across calls stops allocating once it has grown.
+ */
+template<typename Derived>
+void EncodeJson(const Eigen::DenseBase<Derived>& matrix, std::string& str);
+
+/**
+ * Encode an Eigen matrix to Json format through an output iterator.
+ */
+template<typename Derived, typename OutputIt>
+OutputIt EncodeJson(const Eigen::DenseBase<Derived>& matrix, OutputIt out);
+
+/**
+ * Upper bound on the size of the Json encoding of an arithmetic matrix,
+ * computed from its dimensions.
+ */
+template<typename Derived>
+size_t MaxEncodeJsonSize(const Eigen::DenseBase<Derived>& matrix);
+
+/**
+ * Decode an Eigen matrix from the binary tensor format produced by
+ * ctrlutils.redis.encode_tensor() in Python:
+ *
+ * Format:
+ *   "( rows [cols] ) dtype " followed by the raw little-endian data in
+ *   row-major order. Column vectors have a 1-d shape. Bool tensors are
+ *   bit-packed like numpy.packbits(), with the first element in the most
+ *   significant bit of each byte.
+ *
+ * Usage:
+ *   Eigen::Vector3d x = DecodeTensor<Eigen::Vector3d>(EncodeTensor(x));
+ */
+template<typename Derived>
+Derived DecodeTensor(std::string_view str);
+
+/**
+ * Decode an Eigen matrix from the binary tensor format in place.
+ *
+ * The matrix is only resized if its dimensions differ from the tensor's, so
+ * decoding into a preallocated matrix does not allocate.
+ *
+ * Usage:
+ *   Eigen::MatrixXd A(3, 4);
+ *   DecodeTensor(str, A);
+ */
+template<typename Derived>
+void DecodeTensor(std::string_view str, Eigen::PlainObjectBase<Derived>& matrix);
+
+/**
+ * Encode an Eigen matrix to the binary tensor format readable by
+ * ctrlutils.redis.decode_tensor() in Python:
+ *
+ * Usage:
+ *   std::string x = EncodeTensor(Eigen::Vector3d(1, 2, 3));    // "( 3 ) float64 ..."
+ *   std::string A = EncodeTensor(Eigen::Matrix2f(1, 2, 3, 4)); // "( 2 2 ) float32 ..."
+ */
+template<typename Derived>
+std::string EncodeTensor(const Eigen::DenseBase<Derived>& matrix);
+
+/**
+ * Returns whether the string is in the binary tensor format.
+ *
+ * Matlab and Json strings never start with "(", so this can be used to detect
+ * the format of an encoded matrix.
+ */
+inline bool IsTensorString(std::string_view str) {
+  return str.size() >= 2 && str[0] == '(' && str[1] == ' ';
+}
+
+/**
+ * Numpy dtype names for the scalar types supported by the tensor format.
+ */
+template<typename Scalar>
+struct TensorDtype;
+
+template<> struct TensorDtype<bool> { static constexpr const char* name = "bool"; };
+template<> struct TensorDtype<float> { static constexpr const char* name = "float32"; };
+template<> struct TensorDtype<double> { static constexpr const char* name = "float64"; };
+template<> struct TensorDtype<std::int8_t> { static constexpr const char* name = "int8"; };
+template<> struct TensorDtype<std::int16_t> { static constexpr const char* name = "int16"; };
+template<> struct TensorDtype<std::int32_t> { static constexpr const char* name = "int32"; };
+template<> struct TensorDtype<std::int64_t> { static constexpr const char* name = "int64"; };
+template<> struct TensorDtype<std::uint8_t> { static constexpr const char* name = "uint8"; };
+template<> struct TensorDtype<std::uint16_t> { static constexpr const char* name = "uint16"; };
+template<> struct TensorDtype<std::uint32_t> { static constexpr const char* name = "uint32"; };
+template<> struct TensorDtype<std::uint64_t> { static constexpr const char* name = "uint64"; };
+
 }  // namespace ctrl_utils
 
 namespace Eigen {
@@ -66,8 +225,7 @@ template<typename Scalar, int Rows, int Cols, int Options, int MaxRows, int MaxC
 std::stringstream& operator>>(std::stringstream& ss,
                               Eigen::Matrix<Scalar, Rows, Cols, Options,
                                             MaxRows, MaxCols>& matrix) {
-  using PlainMatrix = Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>;
-  matrix = ctrl_utils::DecodeMatlab<PlainMatrix>(ss.str());
+  ctrl_utils::DecodeMatlab(ss.str(), matrix);
   return ss;
 }
 
@@ -93,217 +251,667 @@ std::stringstream& operator<<(std::stringstream& ss, const Eigen::QuaternionBase
 
 namespace ctrl_utils {
 
-template<typename Derived>
-Derived DecodeMatlab(const std::string& str) {
-  std::string str_local = str;
+namespace eigen_string_internal {
 
-  // Create matrix to return
-  Derived matrix;
-  size_t num_cols = matrix.cols();
-  size_t num_rows = matrix.rows();
-  typename Derived::Scalar eof;  // Used to check for eof and print Matrix scalar type
-
-  // Count number of columns
-  size_t idx_col_end = 0;
-  if (num_cols == 0 || (num_cols == 1 && num_rows == 0)) {
-    num_cols = 0;
-    size_t idx = 0;
-    idx_col_end = str.find_first_of(';');
-    while (idx < idx_col_end) {
-      // Skip over extra whitespace
-      idx = str.find_first_not_of(' ', idx);
-      if (idx >= idx_col_end) break;
-
-      // Find next delimiter
-      if (str[idx] == ';') break;
-      idx = str.find_first_of(' ', idx + 1);
-      ++num_cols;
-    }
+/**
+ * Text formats sharing the decoder below. Matlab separates values with
+ * whitespace and rows with ';'. Json additionally separates values with ',',
+ * and holds either one array of values or an array of row arrays, with empty
+ * rows ignored.
+ */
+enum class TextFormat { kMatlab, kJson };
+
+template<TextFormat kFormat>
+inline bool IsSeparator(char c) {
+  if (c == ' ' || c == '\t' || c == '\n' || c == '\r') return true;
+  return kFormat == TextFormat::kJson && c == ',';
+}
+
+template<TextFormat kFormat>
+inline bool IsRowEnd(char c) {
+  return c == (kFormat == TextFormat::kMatlab ? ';' : ']');
+}
+
+inline bool IsDelimiter(char c) {
+  return IsSeparator<TextFormat::kJson>(c) || c == ';' || c == '[' || c == ']';
+}
+
+/**
+ * Converts 8 decimal digits to an integer.
+ */
+inline uint32_t ParseEightDigits(const char* digits) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // Combine adjacent digits into pairs, pairs into quads, and quads into the
+  // result with multiplications within a 64-bit word.
+  uint64_t chunk;
+  std::memcpy(&chunk, digits, sizeof(chunk));
+  chunk = ((chunk & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+  chunk = ((chunk & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+  return static_cast<uint32_t>(((chunk & 0x0000FFFF0000FFFF) * 42949672960001) >> 32);
+#else
+  uint32_t value = 0;
+  for (size_t i = 0; i < 8; i++) value = 10 * value + (digits[i] - '0');
+  return value;
+#endif
+}
+
+/**
+ * Returns whether the 8 characters packed in the word are all decimal digits.
+ */
+inline bool IsEightDigits(uint64_t chunk) {
+  // Digits are 0x30-0x39, so their high nibbles are 3 and adding 6 to their low
+  // nibbles does not carry.
+  return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+          (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+         0x3333333333333333;
+}
+
+/**
+ * Appends the decimal digits at the start of [first, last) to the integer.
+ *
+ * @return Pointer past the digits.
+ */
+inline const char* AccumulateDigits(const char* first, const char* last,
+                                    uint64_t& value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // Convert 8 digits at a time while they last.
+  while (last - first >= 8) {
+    uint64_t chunk;
+    std::memcpy(&chunk, first, sizeof(chunk));
+    if (!IsEightDigits(chunk)) break;
+    value = 100000000 * value + ParseEightDigits(first);
+    first += 8;
+  }
+#endif  // __BYTE_ORDER__
+  for (; first != last && static_cast<unsigned char>(*first - '0') < 10; ++first) {
+    value = 10 * value + (*first - '0');
   }
+  return first;
+}
 
-  // Count number of rows
-  if (num_rows == 0) {
-    size_t idx = idx_col_end;
-    if (idx_col_end != 0) {  // First row already traversed
-      idx = idx_col_end;
-      num_rows = 1;
-    }
-    while (idx != std::string::npos) {
-      // Clear semicolons as we go
-      if (idx != 0) str_local[idx] = ' ';
+/**
+ * Parses a float or double at the start of [first, last) when the result can
+ * be computed exactly with one multiplication or division.
+ *
+ * This covers the values that text-encoded matrices usually hold: up to 15
+ * significant digits for doubles (7 for floats) and small exponents. A
+ * mantissa below 2^53 (2^24) and a power of ten up to 1e22 (1e10) are both
+ * exact, so the correctly rounded product or quotient equals the
+ * correctly rounded decimal value (Clinger's fast path), and the result is
+ * bit-identical to std::from_chars.
+ *
+ * @return Pointer past the parsed characters, or nullptr if the string needs
+ *         the general parser.
+ */
+template<typename Scalar>
+const char* ParseFloatFast(const char* first, const char* last, Scalar& value) {
+  static_assert(std::is_same<Scalar, float>::value || std::is_same<Scalar, double>::value,
+                "ParseFloatFast() only supports float and double.");
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+  constexpr bool kIsDouble = std::is_same<Scalar, double>::value;
+  constexpr uint64_t kMaxMantissa = uint64_t{1} << std::numeric_limits<Scalar>::digits;
+  constexpr int kMaxExponent = kIsDouble ? 22 : 10;
+  static constexpr double kPowersOf10[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  if (!std::numeric_limits<Scalar>::is_iec559) return nullptr;
+
+  // Grammar: -?[0-9]+(\.[0-9]+)?([eE][+-]?[0-9]{1,4})?
+  const char* it = first;
+  const bool is_negative = it != last && *it == '-';
+  if (is_negative) ++it;
+
+  uint64_t mantissa = 0;
+  const char* int_digits = it;
+  it = AccumulateDigits(it, last, mantissa);
+  const size_t num_int_digits = it - int_digits;
+  if (num_int_digits == 0) return nullptr;
+
+  size_t num_frac_digits = 0;
+  if (it != last && *it == '.') {
+    const char* frac_digits = ++it;
+    it = AccumulateDigits(it, last, mantissa);
+    num_frac_digits = it - frac_digits;
+    if (num_frac_digits == 0) return nullptr;
+  }
+  // Up to 19 digits fit in a uint64_t.
+  if (num_int_digits + num_frac_digits > 19) return nullptr;
+
+  int exponent = 0;
+  if (it != last && (*it == 'e' || *it == 'E')) {
+    ++it;
+    const bool is_exponent_negative = it != last && *it == '-';
+    if (it != last && (*it == '-' || *it == '+')) ++it;
+    uint64_t abs_exponent = 0;
+    const char* exponent_digits = it;
+    it = AccumulateDigits(it, last, abs_exponent);
+    const size_t num_exponent_digits = it - exponent_digits;
+    if (num_exponent_digits == 0 || num_exponent_digits > 4) return nullptr;
+    exponent = is_exponent_negative ? -static_cast<int>(abs_exponent)
+                                    : static_cast<int>(abs_exponent);
+  }
+  exponent -= static_cast<int>(num_frac_digits);
 
-      // Find next delimiter
-      idx = str.find_first_of(';', idx + 1);
-      ++num_rows;
-    }
-    // Ignore trailing semicolon
-    idx = str.find_last_not_of(' ');
-    if (str[idx] == ';') --num_rows;
+  if (mantissa == 0) {
+    value = is_negative ? -Scalar(0) : Scalar(0);
+    return it;
+  }
+  if (mantissa > kMaxMantissa || exponent < -kMaxExponent || exponent > kMaxExponent) {
+    return nullptr;
+  }
+
+  Scalar result = static_cast<Scalar>(mantissa);
+  if (exponent < 0) {
+    result /= static_cast<Scalar>(kPowersOf10[-exponent]);
   } else {
-    // Clear remaining semicolons
-    for (size_t idx = idx_col_end; idx < str.size(); idx++) {
-      if (str[idx] == ';') str_local[idx] = ' ';
-    }
+    result *= static_cast<Scalar>(kPowersOf10[exponent]);
   }
+  value = is_negative ? -result : result;
+  return it;
+#else   // FLT_EVAL_METHOD
+  // Intermediate results may carry extra precision and round twice.
+  return nullptr;
+#endif  // FLT_EVAL_METHOD
+}
 
-  // Check number of rows and columns
-  if (num_cols == 0)
-    throw std::invalid_argument(
-        "DecodeMatlab(): Failed to decode Eigen::MatrixX" +
-        std::string(typeid(eof).name()) + "(" + std::to_string(num_rows) +
-        ", " + std::to_string(num_cols) + ") from: (" + str + ").");
-  if (num_rows == 1) {
-    // Convert to vector
-    num_rows = num_cols;
-    num_cols = 1;
+/**
+ * Parses the scalar at the start of [first, last).
+ *
+ * @return Pointer past the parsed characters, or nullptr on failure.
+ */
+template<typename Scalar>
+const char* ParseScalar(const char* first, const char* last, Scalar& value) {
+#ifdef __cpp_lib_to_chars
+  if constexpr (string_internal::IsCharconv<Scalar>::value) {
+    // std::from_chars does not accept a leading '+'.
+    if (last - first > 1 && first[0] == '+' && first[1] != '-') ++first;
+    const std::from_chars_result result = std::from_chars(first, last, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
   }
-  if (matrix.rows() == 0 || matrix.cols() == 0) {
-    matrix.resize(num_rows, num_cols);
+#endif  // __cpp_lib_to_chars
+  const char* token_end = first;
+  while (token_end != last && !IsDelimiter(*token_end)) ++token_end;
+  std::stringstream ss(std::string(first, token_end));
+  ss >> value;
+  return ss.fail() || !ss.eof() ? nullptr : token_end;
+}
+
+template<TextFormat kFormat, typename Scalar>
+[[noreturn]] void ThrowDecodeError(std::string_view str, size_t num_rows, size_t num_cols) {
+  const std::string message =
+      std::string(kFormat == TextFormat::kMatlab ? "DecodeMatlab()" : "DecodeJson()") +
+      ": Failed to decode Eigen::MatrixX" + typeid(Scalar).name() + "(" +
+      std::to_string(num_rows) + ", " + std::to_string(num_cols) + ") from: (" +
+      std::string(str) + ").";
+  if constexpr (kFormat == TextFormat::kMatlab) {
+    throw std::invalid_argument(message);
+  } else {
+    throw std::runtime_error(message);
   }
+}
+
+/**
+ * Decodes a Matlab or Json string in a single pass.
+ */
+template<TextFormat kFormat, typename Derived>
+void DecodeText(std::string_view str, Eigen::PlainObjectBase<Derived>& matrix) {
+  using Scalar = typename Derived::Scalar;
+  constexpr int kRows = Derived::RowsAtCompileTime;
+  constexpr int kCols = Derived::ColsAtCompileTime;
+  constexpr bool kIsFixedSize = kRows != Eigen::Dynamic && kCols != Eigen::Dynamic;
+  constexpr bool kIsFloat =
+      std::is_same<Scalar, float>::value || std::is_same<Scalar, double>::value;
+
+  size_t num_values = 0;
+  size_t num_rows = 0;
+  size_t num_cols = 0;  // Values in the first row
+  size_t num_row_values = 0;
+  size_t num_slow_values = 0;
+  bool is_rectangular = true;
+
+  // Json brackets: depth is 1 inside the outer array and 2 inside a row.
+  int depth = 0;
+  bool is_nested = false;  // Whether the outer array holds rows
+  bool is_closed = false;  // Whether the outer array has ended
+  auto ThrowError = [&]() {
+    ThrowDecodeError<kFormat, Scalar>(str, num_rows, num_cols);
+  };
+  auto EndRow = [&]() {
+    if (num_row_values == 0) return;  // Ignore empty rows
+    if (num_rows == 0) {
+      num_cols = num_row_values;
+    } else if (num_row_values != num_cols) {
+      is_rectangular = false;
+    }
+    ++num_rows;
+    num_row_values = 0;
+  };
+
+  // Dynamic matrices are sized after parsing, so their values are buffered.
+  thread_local std::vector<Scalar> values;
+  if constexpr (!kIsFixedSize) values.clear();
+
+  const char* it = str.data();
+  const char* end = str.data() + str.size();
+  while (it != end) {
+    if (IsSeparator<kFormat>(*it)) {
+      ++it;
+      continue;
+    }
+    if constexpr (kFormat == TextFormat::kJson) {
+      if (is_closed) ThrowError();
+      if (*it == '[') {
+        // The outer array holds either values or rows, and rows hold values.
+        if (depth == 2 || (depth == 1 && num_values > 0 && !is_nested)) {
+          ThrowError();
+        }
+        if (depth == 1) is_nested = true;
+        ++depth;
+        ++it;
+        continue;
+      }
+      if (*it == ']') {
+        if (depth == 0) ThrowError();
+        EndRow();
+        is_closed = --depth == 0;
+        ++it;
+        continue;
+      }
+      if (depth == 0 || (depth == 1 && is_nested)) ThrowError();
+    } else if (IsRowEnd<kFormat>(*it)) {
+      EndRow();
+      ++it;
+      continue;
+    }
 
-  // Parse matrix
-  std::stringstream ss(str_local);
-  for (size_t i = 0; i < num_rows; ++i) {
-    for (size_t j = 0; j < num_cols; ++j) {
-      ss >> matrix(i,j);
-      if (ss.fail()) {
-        throw std::invalid_argument(
-            "DecodeMatlab(): Failed to decode Eigen::MatrixX" +
-            std::string(typeid(eof).name()) + "(" + std::to_string(num_rows) +
-            ", " + std::to_string(num_cols) + ") from: (" + str + ").");
+    Scalar value;
+    const char* next = nullptr;
+    if constexpr (kIsFloat) {
+      // Matrices are usually formatted uniformly, so stop trying the fast path
+      // once most values have needed the general parser (e.g. 17-digit
+      // doubles) rather than scanning every value twice.
+      if (num_slow_values < 8 || 2 * num_slow_values < num_values) {
+        next = ParseFloatFast(it, end, value);
+        if (next == nullptr) ++num_slow_values;
       }
     }
+    if (next == nullptr) next = ParseScalar(it, end, value);
+    it = next;
+    if (it == nullptr ||
+        (it != end && !IsSeparator<kFormat>(*it) && !IsRowEnd<kFormat>(*it))) {
+      ThrowError();
+    }
+    if constexpr (kIsFixedSize) {
+      // Fill fixed-size matrices in row-major order regardless of rows.
+      if (num_values >= static_cast<size_t>(kRows * kCols)) ThrowError();
+      matrix(num_values / kCols, num_values % kCols) = value;
+    } else {
+      values.push_back(value);
+    }
+    ++num_values;
+    ++num_row_values;
   }
+  if constexpr (kFormat == TextFormat::kJson) {
+    if (!is_closed) ThrowError();
+  }
+  EndRow();
 
-  // Make sure there are no numbers left
-  ss >> eof;
-  if (!ss.fail()) {
-    throw std::invalid_argument(
-        "DecodeMatlab(): Failed to decode Eigen::MatrixX" +
-        std::string(typeid(eof).name()) + "(" + std::to_string(num_rows) +
-        ", " + std::to_string(num_cols) + ") from: (" + str + ").");
+  if constexpr (kIsFixedSize) {
+    if (num_values != static_cast<size_t>(kRows * kCols)) ThrowError();
+    return;
+  } else {
+    // Use the row structure of the string only for fully dynamic matrices.
+    if (num_values == 0) ThrowError();
+    size_t rows = 0;
+    size_t cols = 0;
+    if (kRows != Eigen::Dynamic) {
+      rows = kRows;
+      cols = num_values / rows;
+    } else if (kCols != Eigen::Dynamic) {
+      cols = kCols;
+      rows = num_values / cols;
+    } else if (!is_rectangular) {
+      ThrowError();
+    } else if (num_rows == 1) {
+      // Convert to vector
+      rows = num_cols;
+      cols = 1;
+    } else {
+      rows = num_rows;
+      cols = num_cols;
+    }
+    if (rows * cols != num_values) ThrowError();
+
+    if (static_cast<size_t>(matrix.rows()) != rows ||
+        static_cast<size_t>(matrix.cols()) != cols) {
+      matrix.resize(rows, cols);
+    }
+    for (size_t i = 0; i < rows; ++i) {
+      for (size_t j = 0; j < cols; ++j) {
+        matrix(i,j) = values[i * cols + j];
+      }
+    }
   }
+}
+
+}  // namespace eigen_string_internal
 
+template<typename Derived>
+Derived DecodeMatlab(std::string_view str) {
+  Derived matrix;
+  DecodeMatlab(str, matrix);
   return matrix;
 }
 
 template<typename Derived>
-std::string EncodeMatlab(const Eigen::DenseBase<Derived>& matrix) {
-  std::stringstream ss;
-  ss.precision(std::numeric_limits<typename Derived::Scalar>::digits10);
+void DecodeMatlab(std::string_view str, Eigen::PlainObjectBase<Derived>& matrix) {
+  eigen_string_internal::DecodeText<eigen_string_internal::TextFormat::kMatlab>(
+      str, matrix);
+}
+
+namespace eigen_string_internal {
+
+/**
+ * Upper bound on the formatted size of an arithmetic scalar.
+ */
+template<typename Scalar>
+constexpr size_t MaxScalarSize() {
+  // Sign and digits for integers. Sign, digits, point, and a signed exponent
+  // of up to 4 digits for floating point numbers.
+  return std::numeric_limits<Scalar>::is_integer
+             ? std::numeric_limits<Scalar>::digits10 + 2
+             : std::numeric_limits<Scalar>::max_digits10 + 8;
+}
+
+/**
+ * Formats the scalar and passes the characters to append(data, size).
+ */
+template<typename Scalar, typename Append>
+void AppendScalar(const Scalar& value, Append& append) {
+#ifdef __cpp_lib_to_chars
+  if constexpr (string_internal::IsCharconv<Scalar>::value) {
+    char buffer[string_internal::kMaxCharconvSize];
+    const std::to_chars_result result =
+        std::to_chars(buffer, buffer + sizeof(buffer), value);
+    append(buffer, result.ptr - buffer);
+    return;
+  }
+#endif  // __cpp_lib_to_chars
+  thread_local std::stringstream ss;
+  ss.str(std::string());
+  ss.clear();
+  ss.precision(std::numeric_limits<Scalar>::digits10);
+  ss << value;
+  const std::string str = ss.str();
+  append(str.data(), str.size());
+}
+
+template<typename Derived, typename Append>
+void WriteMatlab(const Eigen::DenseBase<Derived>& matrix, Append& append) {
   if (matrix.cols() == 1) { // Column vector
     // [[1],[2],[3],[4]] => "1 2 3 4"
     for (int i = 0; i < matrix.rows(); ++i) {
-      if (i > 0) ss << " ";
-      ss << matrix(i);
+      if (i > 0) append(" ", 1);
+      AppendScalar(matrix(i), append);
     }
   } else { // matrix
     // [1,2,3,4]     => "1 2 3 4"
     // [[1,2],[3,4]] => "1 2; 3 4"
     for (int i = 0; i < matrix.rows(); ++i) {
-      if (i > 0) ss << "; ";
+      if (i > 0) append("; ", 2);
       for (int j = 0; j < matrix.cols(); ++j) {
-        if (j > 0) ss << " ";
-        ss << matrix(i,j);
+        if (j > 0) append(" ", 1);
+        AppendScalar(matrix(i,j), append);
       }
     }
   }
-  return ss.str();
 }
 
-template<typename Derived>
-std::string EncodeJson(const Eigen::DenseBase<Derived>& matrix) {
-  std::string s = "[";
+template<typename Derived, typename Append>
+void WriteJson(const Eigen::DenseBase<Derived>& matrix, Append& append) {
+  append("[", 1);
   if (matrix.cols() == 1) { // Column vector
     // [[1],[2],[3],[4]] => "[1,2,3,4]"
     for (int i = 0; i < matrix.rows(); ++i) {
-      if (i > 0) s.append(",");
-      s.append(std::to_string(matrix(i,0)));
+      if (i > 0) append(",", 1);
+      AppendScalar(matrix(i,0), append);
     }
   } else { // Matrix
     // [[1,2,3,4]]   => "[1,2,3,4]"
     // [[1,2],[3,4]] => "[[1,2],[3,4]]"
     for (int i = 0; i < matrix.rows(); ++i) {
-      if (i > 0) s.append(",");
+      if (i > 0) append(",", 1);
       // Nest arrays only if there are multiple rows
-      if (matrix.rows() > 1) s.append("[");
+      if (matrix.rows() > 1) append("[", 1);
       for (int j = 0; j < matrix.cols(); ++j) {
-        if (j > 0) s.append(",");
-        s.append(std::to_string(matrix(i,j)));
+        if (j > 0) append(",", 1);
+        AppendScalar(matrix(i,j), append);
       }
       // Nest arrays only if there are multiple rows
-      if (matrix.rows() > 1) s.append("]");
+      if (matrix.rows() > 1) append("]", 1);
     }
   }
-  s.append("]");
-  return s;
+  append("]", 1);
+}
+
+}  // namespace eigen_string_internal
+
+template<typename Derived>
+size_t MaxEncodeMatlabSize(const Eigen::DenseBase<Derived>& matrix) {
+  constexpr size_t kMaxScalarSize =
+      eigen_string_internal::MaxScalarSize<typename Derived::Scalar>();
+  // Each scalar is followed by at most a space or "; ".
+  return matrix.size() * (kMaxScalarSize + 2);
+}
+
+template<typename Derived>
+std::string EncodeMatlab(const Eigen::DenseBase<Derived>& matrix) {
+  std::string str;
+  EncodeMatlab(matrix, str);
+  return str;
+}
+
+template<typename Derived>
+void EncodeMatlab(const Eigen::DenseBase<Derived>& matrix, std::string& str) {
+  str.reserve(str.size() + MaxEncodeMatlabSize(matrix));
+  auto append = [&str](const char* data, size_t size) {
+    str.append(data, size);
+  };
+  eigen_string_internal::WriteMatlab(matrix, append);
+}
+
+template<typename Derived, typename OutputIt>
+OutputIt EncodeMatlab(const Eigen::DenseBase<Derived>& matrix, OutputIt out) {
+  auto append = [&out](const char* data, size_t size) {
+    out = std::copy(data, data + size, out);
+  };
+  eigen_string_internal::WriteMatlab(matrix, append);
+  return out;
+}
+
+template<typename Derived>
+size_t MaxEncodeJsonSize(const Eigen::DenseBase<Derived>& matrix) {
+  constexpr size_t kMaxScalarSize =
+      eigen_string_internal::MaxScalarSize<typename Derived::Scalar>();
+  // Each scalar is followed by at most a comma, and each row is wrapped in
+  // brackets inside the outer brackets.
+  return matrix.size() * (kMaxScalarSize + 1) + 2 * matrix.rows() + 2;
 }
 
 template<typename Derived>
-Derived DecodeJson(const std::string& str) {
-  // Find last nested row delimiter
-  size_t idx_row_end = str.find_last_of(']');
-  if (idx_row_end != std::string::npos) {
-    size_t idx_temp = str.substr(0, idx_row_end).find_last_of(']');
-    if (idx_temp != std::string::npos) idx_row_end = idx_temp;
+std::string EncodeJson(const Eigen::DenseBase<Derived>& matrix) {
+  std::string str;
+  EncodeJson(matrix, str);
+  return str;
+}
+
+template<typename Derived>
+void EncodeJson(const Eigen::DenseBase<Derived>& matrix, std::string& str) {
+  str.reserve(str.size() + MaxEncodeJsonSize(matrix));
+  auto append = [&str](const char* data, size_t size) {
+    str.append(data, size);
+  };
+  eigen_string_internal::WriteJson(matrix, append);
+}
+
+template<typename Derived, typename OutputIt>
+OutputIt EncodeJson(const Eigen::DenseBase<Derived>& matrix, OutputIt out) {
+  auto append = [&out](const char* data, size_t size) {
+    out = std::copy(data, data + size, out);
+  };
+  eigen_string_internal::WriteJson(matrix, append);
+  return out;
+}
+
+template<typename Derived>
+Derived DecodeJson(std::string_view str) {
+  Derived matrix;
+  DecodeJson(str, matrix);
+  return matrix;
+}
+
+template<typename Derived>
+void DecodeJson(std::string_view str, Eigen::PlainObjectBase<Derived>& matrix) {
+  eigen_string_internal::DecodeText<eigen_string_internal::TextFormat::kJson>(
+      str, matrix);
+}
+
+/**
+ * Copies scalars between native and little-endian byte order.
+ */
+template<typename Scalar>
+void CopyLittleEndian(char* dest, const char* src, size_t size) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  for (size_t i = 0; i < size; i += sizeof(Scalar)) {
+    for (size_t j = 0; j < sizeof(Scalar); j++) {
+      dest[i + j] = src[i + sizeof(Scalar) - 1 - j];
+    }
   }
+#else   // __BYTE_ORDER__
+  std::memcpy(dest, src, size);
+#endif  // __BYTE_ORDER__
+}
 
-  // Count number of columns
-  size_t num_cols = 0;
-  size_t idx = 0;
-  size_t idx_col_end = str.find_first_of(']');
-  while (idx < idx_col_end) {
-    // Skip over extra whitespace
-    idx = str.find_first_not_of(' ', idx);
-    if (idx >= idx_col_end) break;
-
-    // Find next delimiter
-    idx = str.find_first_of(',', idx + 1);
-    ++num_cols;
+template<typename Derived>
+std::string EncodeTensor(const Eigen::DenseBase<Derived>& matrix) {
+  using Scalar = typename Derived::Scalar;
+  constexpr int kRows = Derived::RowsAtCompileTime;
+  constexpr int kCols = Derived::ColsAtCompileTime;
+
+  // Evaluate into row-major order to match numpy.
+  const Eigen::Matrix<Scalar, kRows, kCols, kCols == 1 ? Eigen::ColMajor : Eigen::RowMajor,
+                      Derived::MaxRowsAtCompileTime, Derived::MaxColsAtCompileTime>
+      matrix_rm = matrix;
+
+  std::string str = "( " + std::to_string(matrix_rm.rows()) + " ";
+  if (matrix_rm.cols() != 1) str += std::to_string(matrix_rm.cols()) + " ";
+  str += ") ";
+  str += TensorDtype<Scalar>::name;
+  str += " ";
+
+  // Append raw data.
+  const size_t idx_data = str.size();
+  if constexpr (std::is_same_v<Scalar, bool>) {
+    str.resize(idx_data + (matrix_rm.size() + 7) / 8, '\0');
+    for (Eigen::Index i = 0; i < matrix_rm.size(); i++) {
+      if (!matrix_rm.data()[i]) continue;
+      str[idx_data + i / 8] |= static_cast<char>(0x80 >> (i % 8));
+    }
+    return str;
   }
-  if (idx > idx_col_end) idx = idx_col_end;
+  const size_t num_bytes = matrix_rm.size() * sizeof(Scalar);
+  str.resize(idx_data + num_bytes);
+  CopyLittleEndian<Scalar>(&str[idx_data],
+                           reinterpret_cast<const char*>(matrix_rm.data()), num_bytes);
+  return str;
+}
 
-  // Count number of rows
-  size_t num_rows = 1;  // First row already traversed
-  while (idx < idx_row_end) {
-    // Skip over irrelevant characters
-    idx = str.find_first_not_of(']', idx);
-    if (idx >= idx_row_end) break;
+template<typename Derived>
+Derived DecodeTensor(std::string_view str) {
+  Derived matrix;
+  DecodeTensor(str, matrix);
+  return matrix;
+}
 
-    // Find next delimiter
-    idx = str.find_first_of(']', idx + 1);
-    ++num_rows;
+template<typename Derived>
+void DecodeTensor(std::string_view str, Eigen::PlainObjectBase<Derived>& matrix) {
+  using Scalar = typename Derived::Scalar;
+  auto Error = [&str](const std::string& message) {
+    return std::invalid_argument(
+        "DecodeTensor(): " + message + " from: (" +
+        std::string(str.substr(0, str.find(')') + 1)) + " ...).");
+  };
+
+  // Parse shape.
+  if (!IsTensorString(str)) throw Error("Expected '(' at index 0");
+  size_t shape[2] = {0, 1};
+  size_t num_dims = 0;
+  size_t idx = 2;
+  while (true) {
+    const size_t idx_end = str.find(' ', idx);
+    if (idx_end == std::string_view::npos) throw Error("Unterminated shape");
+    const std::string word(str.substr(idx, idx_end - idx));
+    idx = idx_end + 1;
+    if (word == ")") break;
+    if (num_dims >= 2) throw Error("Expected 1-d or 2-d tensor");
+    try {
+      shape[num_dims++] = std::stoul(word);
+    } catch (const std::exception&) {
+      throw Error("Invalid shape");
+    }
   }
+  if (num_dims == 0) throw Error("Expected 1-d or 2-d tensor");
 
-  // Check number of rows and columns
-  if (num_cols == 0)
-    throw std::runtime_error("RedisClient: Failed to decode Eigen Matrix from: " + str + ".");
-  if (num_rows == 1) {
-    // Convert to vector
-    num_rows = num_cols;
-    num_cols = 1;
+  // Parse dtype.
+  const size_t idx_dtype_end = str.find(' ', idx);
+  if (idx_dtype_end == std::string_view::npos ||
+      str.compare(idx, idx_dtype_end - idx, TensorDtype<Scalar>::name) != 0) {
+    throw Error("Expected dtype " + std::string(TensorDtype<Scalar>::name));
   }
-
-  // Parse matrix
-  Eigen::MatrixXd matrix(num_rows, num_cols);
-  std::string str_local(str);
-  for (char delimiter : ",[]") {
-    std::replace(str_local.begin(), str_local.end(), delimiter, ' ');
+  idx = idx_dtype_end + 1;
+
+  // Check dimensions.
+  size_t num_rows = shape[0];
+  size_t num_cols = shape[1];
+  if (num_dims == 1 && Derived::RowsAtCompileTime == 1) {
+    // Convert to row vector.
+    std::swap(num_rows, num_cols);
   }
-  std::stringstream ss(str_local);
-  for (size_t i = 0; i < num_rows; ++i) {
-    for (size_t j = 0; j < num_cols; ++j) {
-      std::string val;
-      ss >> val;
-      try {
-        matrix(i,j) = std::stod(val);
-      } catch (const std::exception& e) {
-        throw std::runtime_error("RedisClient: Failed to decode Eigen Matrix from: " + str + ".");
+  if ((Derived::RowsAtCompileTime != Eigen::Dynamic &&
+       num_rows != static_cast<size_t>(Derived::RowsAtCompileTime)) ||
+      (Derived::ColsAtCompileTime != Eigen::Dynamic &&
+       num_cols != static_cast<size_t>(Derived::ColsAtCompileTime))) {
+    throw Error("Mismatched dimensions");
+  }
+  const size_t num_bytes = std::is_same_v<Scalar, bool>
+                               ? (num_rows * num_cols + 7) / 8
+                               : num_rows * num_cols * sizeof(Scalar);
+  if (str.size() - idx != num_bytes) throw Error("Mismatched data size");
+
+  // Copy row-major data.
+  matrix.resize(num_rows, num_cols);
+  if constexpr (std::is_same_v<Scalar, bool>) {
+    for (size_t i = 0; i < num_rows; i++) {
+      for (size_t j = 0; j < num_cols; j++) {
+        const size_t k = i * num_cols + j;
+        const unsigned char byte = str[idx + k / 8];
+        matrix(i, j) = (byte >> (7 - k % 8)) & 1;
       }
     }
+    return;
+  }
+  if (Derived::IsRowMajor || num_rows == 1 || num_cols == 1) {
+    CopyLittleEndian<Scalar>(reinterpret_cast<char*>(matrix.data()),
+                             str.data() + idx, num_bytes);
+    return;
+  }
+  for (size_t i = 0; i < num_rows; i++) {
+    for (size_t j = 0; j < num_cols; j++) {
+      CopyLittleEndian<Scalar>(reinterpret_cast<char*>(&matrix(i, j)),
+                               str.data() + idx, sizeof(Scalar));
+      idx += sizeof(Scalar);
+    }
   }
-
-  return matrix;
 }
 
 }  // namespace ctrl_utils
@@ -24,8 +24,13 @@ inline std::string ToString(const nlohmann::json& value) {
 }
 
 template <>
-inline nlohmann::json FromString(const std::string& str) {
-  return nlohmann::json::parse(str);
+inline void FromString(std::string_view str, nlohmann::json& value) {
+  value = nlohmann::json::parse(str.begin(), str.end());
+}
+
+template <>
+inline nlohmann::json FromString(std::string_view str) {
+  return nlohmann::json::parse(str.begin(), str.end());
 }
 
 }  // namespace ctrl_utils
@@ -23,9 +23,9 @@ namespace ctrl_utils {
  *   "nrows ncols cvtype bytedata"
  */
 template <>
-inline void FromString(const std::string& str, cv::Mat& image) {
+inline void FromString(std::string_view str, cv::Mat& image) {
   // Read image type.
-  std::stringstream ss(str);
+  StringViewStream ss(str);
   int type;
   ss >> type;
 
@@ -46,10 +46,15 @@ inline void FromString(const std::string& str, cv::Mat& image) {
       int size;
       ss >> size;
       ss.get();  // Extract space.
-      std::vector<unsigned char> buffer(size);
-      ss.read(reinterpret_cast<char*>(buffer.data()), size);
 
-      // Decode png.
+      // Decode png or exr directly from the string.
+      const size_t idx = ss.tellg();
+      if (!ss || size < 0 || idx + size > str.size()) {
+        image.release();
+        return;
+      }
+      const cv::Mat buffer(1, size, CV_8UC1,
+                           const_cast<char*>(str.data() + idx));
       cv::imdecode(buffer, cv::IMREAD_UNCHANGED, &image);
     } break;
     default: {
@@ -10,22 +10,51 @@
 #ifndef CTRL_UTILS_REDIS_CLIENT_H_
 #define CTRL_UTILS_REDIS_CLIENT_H_
 
+#include <algorithm>      // std::copy, std::find_if, std::max, std::remove_if
+#include <any>            // std::any, std::any_cast
+#include <atomic>         // std::atomic
+#include <chrono>         // std::chrono
 #include <cpp_redis/cpp_redis>
+#include <cstdint>        // uint64_t
+#include <deque>          // std::deque
 #include <exception>      // std::exception
 #include <functional>     // std::function
-#include <future>         // std::future, std::promise
+#include <future>         // std::future, std::promise, std::shared_future
+#include <iterator>       // std::make_move_iterator
+#include <memory>         // std::shared_ptr, std::unique_ptr
+#include <mutex>          // std::mutex, std::unique_lock
 #include <sstream>        // std::stringstream
 #include <string>         // std::string
 #include <tuple>          // std::tuple, std::get
+#include <type_traits>    // std::is_base_of
+#include <unordered_map>  // std::unordered_map
 #include <unordered_set>  // std::unordered_set
 #include <utility>        // std::pair, std::integer_sequence
 
+#include <unistd.h>  // getpid, gethostname
+
+#include "ctrl_utils/compression.h"
+#include "ctrl_utils/eigen_string.h"
+#include "ctrl_utils/redis_stats.h"
+#include "ctrl_utils/shared_memory.h"
 #include "ctrl_utils/string.h"
+#include "ctrl_utils/thread_pool.h"
+#include "ctrl_utils/timer.h"
 #include "ctrl_utils/type_traits.h"
 
 namespace ctrl_utils {
 
+template <typename T>
+class RedisKey;
+
 class RedisClient : public ::cpp_redis::client {
+  // Encodes stream fields with the codec of the stream key.
+  friend class RedisStreamWriter;
+
+  // Sends reused command buffers and decodes into the cache.
+  template <typename T>
+  friend class RedisKey;
+
  private:
   template <typename... Ts>
   using is_all_strings = typename std::enable_if_t<
@@ -45,13 +74,120 @@ class RedisClient : public ::cpp_redis::client {
   using is_all_pairs =
       typename std::enable_if_t<std::conjunction_v<is_pair<Ts>...>>;
 
+  template <typename T>
+  using is_eigen_dense = std::is_base_of<Eigen::DenseBase<T>, T>;
+
+  template <typename T>
+  using is_eigen_plain = std::is_base_of<Eigen::PlainObjectBase<T>, T>;
+
  public:
+  /**
+   * Wire formats for Eigen matrices.
+   */
+  enum class Codec {
+    /// Text format "1 2; 3 4" (see ctrl_utils::EncodeMatlab()).
+    kMatlab,
+    /// Binary format "( 2 2 ) float64 <raw bytes>" (see
+    /// ctrl_utils::EncodeTensor()), readable by ctrlutils.redis.decode_tensor()
+    /// in Python.
+    kTensor,
+  };
+
+  /**
+   * Delivery modes for subscribe() and psubscribe().
+   */
+  enum class SubscriptionMode {
+    /// Deliver every message in order.
+    kQueue,
+    /// Deliver only the latest message of each channel. Messages that
+    /// arrive while the callback is busy replace the undelivered message of
+    /// their channel, so a slow callback always sees the most recent value of
+    /// every channel that matches a pattern.
+    kLatest,
+  };
+
+  /**
+   * Policy for automatically committing pipelined commands.
+   *
+   * The limits are checked whenever a command is sent and when
+   * RedisClient::commit_if_due() is called, and the pending commands are
+   * committed if any of the enabled limits is reached. No timer runs in the
+   * background, so the policy bounds batch sizes but not latency. Limits set
+   * to zero are disabled.
+   */
+  struct PipelinePolicy {
+    /// Commit when the pending commands reach this many bytes.
+    size_t max_bytes = 0;
+
+    /// Commit when this many commands are pending.
+    size_t max_commands = 0;
+
+    /// Commit at the next check once the oldest pending command is this old.
+    /// Commands wait longer if nothing is sent and commit_if_due() is not
+    /// called.
+    std::chrono::microseconds max_age = std::chrono::microseconds::zero();
+  };
+
+  /**
+   * Counters for tuning the pipeline policy.
+   *
+   * The average batch size is num_commands / num_flushes.
+   */
+  struct PipelineStats {
+    /// Number of commits that sent at least one command.
+    size_t num_flushes = 0;
+
+    /// Total number of commands sent.
+    size_t num_commands = 0;
+
+    /// Total number of RESP-encoded bytes sent.
+    size_t num_bytes = 0;
+
+    /// Largest number of commands sent in one commit.
+    size_t max_batch_commands = 0;
+
+    /// Largest number of bytes sent in one commit.
+    size_t max_batch_bytes = 0;
+  };
+
+  /**
+   * Counters for the read cache.
+   */
+  struct CacheStats {
+    /// Number of GETs served from the cache.
+    size_t num_hits = 0;
+
+    /// Number of GETs on cacheable keys sent to the server.
+    size_t num_misses = 0;
+
+    /// Number of cached values removed after the key changed.
+    size_t num_invalidations = 0;
+  };
+
+  /**
+   * Entry of a Redis stream with field values of the same type.
+   */
+  template <typename T>
+  struct StreamEntry {
+    /// Entry id assigned by Redis (e.g. "1526919030474-0").
+    std::string id;
+
+    /// Field-value pairs in the order they were added.
+    std::vector<std::pair<std::string, T>> fields;
+  };
+
   RedisClient() : cpp_redis::client() {}
 
+  /**
+   * Sends pending commands, waits for their replies, and disconnects.
+   */
+  ~RedisClient();
+
   void connect(const std::string& host = "127.0.0.1", size_t port = 6379,
                const std::string& password = "") {
     host_ = host;
     port_ = port;
+    password_ = password;
     cpp_redis::client::connect(host, port);
 
     if (!password.empty()) {
@@ -62,6 +198,476 @@ class RedisClient : public ::cpp_redis::client {
     }
   }
 
+  /**
+   * Sets the default codec used to encode Eigen matrices in SET, MSET, HSET,
+   * and PUBLISH commands.
+   *
+   * Decoding detects the format automatically, so readers of these keys do not
+   * need to be configured.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.set_codec(ctrl_utils::RedisClient::Codec::kTensor);
+   * redis_client.set("q", Eigen::VectorXd::Zero(7));
+   * redis_client.commit();
+   * ~~~~~~~~~~
+   *
+   * @param codec Default codec.
+   */
+  void set_codec(Codec codec) { codec_ = codec; }
+
+  /**
+   * Sets the codec used to encode Eigen matrices for a specific key, overriding
+   * the default codec.
+   *
+   * @param key Redis key.
+   * @param codec Codec for the key.
+   */
+  void set_codec(const std::string& key, Codec codec) {
+    key_codecs_[key] = codec;
+  }
+
+  /**
+   * Returns the codec used to encode Eigen matrices for the given key.
+   *
+   * @param key Redis key.
+   * @return Codec for the key.
+   */
+  Codec codec(const std::string& key) const {
+    if (key_codecs_.empty()) return codec_;
+    const auto it = key_codecs_.find(key);
+    return it == key_codecs_.end() ? codec_ : it->second;
+  }
+
+  /**
+   * Sets the default compression for encoded values.
+   *
+   * Values at least min_bytes long are compressed before they are sent, and
+   * get and the other read commands decompress them without any change to
+   * call sites. Compressed values carry a self-describing header, so readers
+   * don't need to know the compression settings of the writer. Values
+   * that would not get smaller are sent uncompressed, and values below the
+   * threshold skip compression entirely.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * // Compress values larger than 64 KB, such as point clouds.
+   * redis_client.set_compression(ctrl_utils::Compression::kLz4, 1 << 16);
+   * redis_client.set("camera::points", points);
+   * redis_client.commit();
+   * ~~~~~~~~~~
+   *
+   * @param compression Compression algorithm. Must be compiled in (see
+   *                    ctrl_utils::Compression).
+   * @param min_bytes Smallest encoded value size to compress.
+   */
+  void set_compression(Compression compression, size_t min_bytes = 1 << 16) {
+    CheckCompression(compression);
+    compression_ = compression;
+    compression_min_bytes_ = min_bytes;
+  }
+
+  /**
+   * Sets the compression for a specific key, overriding the default
+   * compression.
+   *
+   * @param key Redis key.
+   * @param compression Compression algorithm, or Compression::kNone to
+   *                    disable compression for the key.
+   * @param min_bytes Smallest encoded value size to compress.
+   */
+  void set_compression(const std::string& key, Compression compression,
+                       size_t min_bytes = 0) {
+    CheckCompression(compression);
+    key_compressions_[key] = {compression, min_bytes};
+  }
+
+  /**
+   * Sets the policy for automatically committing commands.
+   *
+   * Commands sent through RedisClient are counted towards the limits. The
+   * limits are checked whenever a command is sent and when
+   * RedisClient::commit_if_due() is called, so a loop that relies on
+   * PipelinePolicy::max_age should call commit_if_due() periodically.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * ctrl_utils::RedisClient::PipelinePolicy policy;
+   * policy.max_bytes = 64 * 1024;
+   * redis_client.set_pipeline_policy(policy);
+   *
+   * ctrl_utils::Timer timer(1000);
+   * while (true) {
+   *   redis_client.set("q", q);
+   *   redis_client.set("dq", dq);
+   *
+   *   // Commit once per control cycle.
+   *   redis_client.commit_and_sleep(timer);
+   * }
+   * ~~~~~~~~~~
+   *
+   * @param policy Pipeline policy.
+   */
+  void set_pipeline_policy(const PipelinePolicy& policy) {
+    std::unique_lock<std::mutex> lock(mtx_pipeline_);
+    pipeline_policy_ = policy;
+  }
+
+  /**
+   * @return Pipeline policy.
+   */
+  PipelinePolicy pipeline_policy() const {
+    std::unique_lock<std::mutex> lock(mtx_pipeline_);
+    return pipeline_policy_;
+  }
+
+  /**
+   * @return Pipeline counters since the last reset.
+   */
+  PipelineStats pipeline_stats() const {
+    std::unique_lock<std::mutex> lock(mtx_pipeline_);
+    return pipeline_stats_;
+  }
+
+  /**
+   * Resets the pipeline counters.
+   */
+  void reset_pipeline_stats() {
+    std::unique_lock<std::mutex> lock(mtx_pipeline_);
+    pipeline_stats_ = PipelineStats();
+  }
+
+  /**
+   * Enables per-command instrumentation.
+   *
+   * For each command type, the client records how long commands wait in the
+   * pipeline before a commit, the time from the commit until the reply
+   * arrives, and the time spent in the reply callback (decoding the value).
+   * It also counts the RESP bytes sent and received and the number of
+   * commands waiting for replies. Recording costs two clock reads and one
+   * short critical section per command, so it can stay enabled in
+   * production.
+   *
+   * Commands sent while a commit is in progress on another thread may be
+   * attributed to that commit, which shifts a little time from the queue
+   * latency to the reply latency.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.enable_stats();
+   * // ...
+   * const ctrl_utils::RedisStats stats = redis_client.stats();
+   * const auto p99 = stats.commands.at("GET").reply_latency.Percentile(0.99);
+   * ~~~~~~~~~~
+   *
+   * @param enable Whether to record new commands.
+   */
+  void enable_stats(bool enable = true) { is_stats_enabled_ = enable; }
+
+  /**
+   * @return Snapshot of the instrumentation since the last reset.
+   */
+  RedisStats stats() const {
+    std::unique_lock<std::mutex> lock(mtx_stats_);
+    return stats_;
+  }
+
+  /**
+   * Resets the instrumentation. Commands still waiting for replies remain
+   * counted as in flight.
+   */
+  void reset_stats() {
+    std::unique_lock<std::mutex> lock(mtx_stats_);
+    stats_.commands.clear();
+    stats_.max_in_flight = stats_.num_in_flight;
+  }
+
+  /**
+   * Sends all pending commands.
+   *
+   * @return RedisClient reference for command chaining.
+   */
+  RedisClient& commit();
+
+  /**
+   * Sends all pending commands and waits for all replies.
+   *
+   * @return RedisClient reference for command chaining.
+   */
+  RedisClient& sync_commit();
+
+  /**
+   * Sends all pending commands and waits for all replies until the timeout.
+   *
+   * @param timeout Maximum time to wait.
+   * @return RedisClient reference for command chaining.
+   */
+  template <class Rep, class Period>
+  RedisClient& sync_commit(const std::chrono::duration<Rep, Period>& timeout);
+
+  /**
+   * Sends all pending commands if a limit of the pipeline policy is reached.
+   *
+   * @return RedisClient reference for command chaining.
+   */
+  RedisClient& commit_if_due();
+
+  /**
+   * Sends all pending commands and then waits for the next timer loop.
+   *
+   * Use this at the end of a control loop to commit once per cycle.
+   *
+   * @param timer Control loop timer.
+   */
+  void commit_and_sleep(Timer& timer) {
+    commit();
+    timer.Sleep();
+  }
+
+  /**
+   * Caches the decoded values of keys matching the pattern in this client.
+   *
+   * GET commands on cached keys call back immediately with a copy of the
+   * cached value without contacting the server. Cached values are invalidated
+   * through Redis keyspace notifications received on the persistent
+   * subscriber connection, and by writes from this client. This is intended
+   * for configuration-like keys that rarely change. Updates from other
+   * clients become visible once their notifications arrive.
+   *
+   * The cache saves the round trip and the decoding, not the copy: a miss
+   * copies the decoded value into the cache, and a hit copies it out again.
+   * For large dynamic Eigen matrices, RedisKey::Get() copies into its own
+   * value without reallocating, whereas get() allocates a new matrix per hit.
+   *
+   * The server must have keyspace notifications enabled, for example with
+   * `CONFIG SET notify-keyspace-events KA`. This function blocks until the
+   * notification subscription is acknowledged. Enable caching before sending
+   * commands from other threads.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.enable_cache("robot::gains::*");
+   * while (true) {
+   *   // Only the first call reaches the server until the key changes.
+   *   const double kp = redis_client.sync_get<double>("robot::gains::kp");
+   * }
+   * ~~~~~~~~~~
+   *
+   * @param pattern Redis glob pattern of keys to cache.
+   * @param db Redis database index for keyspace notifications.
+   */
+  void enable_cache(const std::string& pattern, int db = 0);
+
+  /**
+   * @return Read cache counters since the last reset.
+   */
+  CacheStats cache_stats() const {
+    std::unique_lock<std::mutex> lock(mtx_cache_);
+    return cache_stats_;
+  }
+
+  /**
+   * Resets the read cache counters.
+   */
+  void reset_cache_stats() {
+    std::unique_lock<std::mutex> lock(mtx_cache_);
+    cache_stats_ = CacheStats();
+  }
+
+  /**
+   * Transfers values of keys matching the pattern through shared memory.
+   *
+   * SET, MSET and PUBLISH write the encoded value into a POSIX shared-memory
+   * segment owned by this client and send a small handle to Redis in its
+   * place. GET, MGET and request() on any RedisClient running on the same host
+   * read the value directly from the segment, so large values like images
+   * never pass through the Redis server. Reading the handle from another host
+   * throws an error.
+   *
+   * Each key keeps only its latest value, so an old handle (e.g. a published
+   * message received late) resolves to the most recent value. Segments are
+   * removed when this client is destroyed.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.enable_shared_memory("camera::*", 4096);
+   * redis_client.set("camera::depth", depth_image);
+   * redis_client.commit();
+   * ~~~~~~~~~~
+   *
+   * @param pattern Redis glob pattern of keys to transfer.
+   * @param min_bytes Encoded values smaller than this are sent through Redis.
+   */
+  void enable_shared_memory(const std::string& pattern, size_t min_bytes = 0) {
+    std::unique_lock<std::mutex> lock(mtx_shared_memory_);
+    shared_memory_patterns_.emplace_back(pattern, min_bytes);
+    is_shared_memory_enabled_ = true;
+  }
+
+  /**
+   * Buffers SETs of keys matching the pattern until the next commit.
+   *
+   * Repeated SETs of a key between commits are coalesced, and commit() sends
+   * only the latest value of each buffered key in a single MSET. GETs of a
+   * buffered key from this client return the pending value without contacting
+   * the server. The reply callbacks of all coalesced SETs receive the reply to
+   * the MSET.
+   *
+   * Each newly buffered key counts as one command toward the pipeline policy
+   * (see set_pipeline_policy()), so commit_if_due() flushes buffered writes.
+   *
+   * Only SET is buffered. Every other command of RedisClient, including
+   * send() and the key commands below, sends the buffered values first so
+   * that commands keep their order. The remaining commands inherited from
+   * cpp_redis::client bypass the buffer and are sent ahead of buffered values
+   * queued before them.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.enable_write_back("robot::command::*");
+   * redis_client.set("robot::command::tau", tau_gravity);
+   * redis_client.set("robot::command::tau", tau_gravity + tau_task);
+   * redis_client.commit();  // Sends only the second value.
+   * ~~~~~~~~~~
+   *
+   * @param pattern Redis glob pattern of keys to buffer.
+   */
+  void enable_write_back(const std::string& pattern) {
+    std::unique_lock<std::mutex> lock(mtx_write_back_);
+    write_back_patterns_.push_back(pattern);
+    is_write_back_enabled_ = true;
+  }
+
+  /**
+   * Sends a raw Redis command. Unlike cpp_redis::client::send(), it sends
+   * buffered writes first (see enable_write_back()) and counts toward the
+   * pipeline policy.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param command Command and its arguments.
+   * @param reply_callback Callback function that gets the reply.
+   * @return RedisClient reference for command chaining.
+   */
+  RedisClient& send(const std::vector<std::string>& command,
+                    const reply_callback_t& reply_callback) {
+    return Send(command, reply_callback);
+  }
+
+  /**
+   * Sends a raw Redis command with std::future. See send() above.
+   *
+   * @param command Command and its arguments.
+   * @return Future reply.
+   */
+  std::future<cpp_redis::reply> send(const std::vector<std::string>& command) {
+    return Send(command);
+  }
+
+  /**
+   * Redis key commands that send buffered writes first (see
+   * enable_write_back()). They hide the cpp_redis::client commands of the
+   * same name and take the same arguments.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   */
+  RedisClient& del(const std::vector<std::string>& keys,
+                   const reply_callback_t& reply_callback) {
+    return Send(KeysCommand("DEL", keys), reply_callback);
+  }
+  std::future<cpp_redis::reply> del(const std::vector<std::string>& keys) {
+    return Send(KeysCommand("DEL", keys));
+  }
+  RedisClient& unlink(const std::vector<std::string>& keys,
+                      const reply_callback_t& reply_callback) {
+    return Send(KeysCommand("UNLINK", keys), reply_callback);
+  }
+  std::future<cpp_redis::reply> unlink(const std::vector<std::string>& keys) {
+    return Send(KeysCommand("UNLINK", keys));
+  }
+  RedisClient& exists(const std::vector<std::string>& keys,
+                      const reply_callback_t& reply_callback) {
+    return Send(KeysCommand("EXISTS", keys), reply_callback);
+  }
+  std::future<cpp_redis::reply> exists(const std::vector<std::string>& keys) {
+    return Send(KeysCommand("EXISTS", keys));
+  }
+  RedisClient& expire(const std::string& key, int seconds,
+                      const reply_callback_t& reply_callback) {
+    return Send({"EXPIRE", key, std::to_string(seconds)}, reply_callback);
+  }
+  std::future<cpp_redis::reply> expire(const std::string& key, int seconds) {
+    return Send({"EXPIRE", key, std::to_string(seconds)});
+  }
+  RedisClient& pexpire(const std::string& key, int milliseconds,
+                       const reply_callback_t& reply_callback) {
+    return Send({"PEXPIRE", key, std::to_string(milliseconds)},
+                reply_callback);
+  }
+  std::future<cpp_redis::reply> pexpire(const std::string& key,
+                                        int milliseconds) {
+    return Send({"PEXPIRE", key, std::to_string(milliseconds)});
+  }
+  RedisClient& persist(const std::string& key,
+                       const reply_callback_t& reply_callback) {
+    return Send({"PERSIST", key}, reply_callback);
+  }
+  std::future<cpp_redis::reply> persist(const std::string& key) {
+    return Send({"PERSIST", key});
+  }
+  RedisClient& rename(const std::string& key, const std::string& newkey,
+                      const reply_callback_t& reply_callback) {
+    return Send({"RENAME", key, newkey}, reply_callback);
+  }
+  std::future<cpp_redis::reply> rename(const std::string& key,
+                                       const std::string& newkey) {
+    return Send({"RENAME", key, newkey});
+  }
+  RedisClient& incr(const std::string& key,
+                    const reply_callback_t& reply_callback) {
+    return Send({"INCR", key}, reply_callback);
+  }
+  std::future<cpp_redis::reply> incr(const std::string& key) {
+    return Send({"INCR", key});
+  }
+  RedisClient& incrby(const std::string& key, int incr,
+                      const reply_callback_t& reply_callback) {
+    return Send({"INCRBY", key, std::to_string(incr)}, reply_callback);
+  }
+  std::future<cpp_redis::reply> incrby(const std::string& key, int incr) {
+    return Send({"INCRBY", key, std::to_string(incr)});
+  }
+  RedisClient& decr(const std::string& key,
+                    const reply_callback_t& reply_callback) {
+    return Send({"DECR", key}, reply_callback);
+  }
+  std::future<cpp_redis::reply> decr(const std::string& key) {
+    return Send({"DECR", key});
+  }
+  RedisClient& decrby(const std::string& key, int decr,
+                      const reply_callback_t& reply_callback) {
+    return Send({"DECRBY", key, std::to_string(decr)}, reply_callback);
+  }
+  std::future<cpp_redis::reply> decrby(const std::string& key, int decr) {
+    return Send({"DECRBY", key, std::to_string(decr)});
+  }
+  RedisClient& append(const std::string& key, const std::string& value,
+                      const reply_callback_t& reply_callback) {
+    return Send({"APPEND", key, value}, reply_callback);
+  }
+  std::future<cpp_redis::reply> append(const std::string& key,
+                                       const std::string& value) {
+    return Send({"APPEND", key, value});
+  }
+  RedisClient& getset(const std::string& key, const std::string& value,
+                      const reply_callback_t& reply_callback) {
+    return Send({"GETSET", key, value}, reply_callback);
+  }
+  std::future<cpp_redis::reply> getset(const std::string& key,
+                                       const std::string& value) {
+    return Send({"GETSET", key, value});
+  }
+
   /**
    * Asynchronous Redis GET command with std::future.
    *
@@ -163,34 +769,82 @@ class RedisClient : public ::cpp_redis::client {
   T sync_get(const std::string& key);
 
   /**
-   * Asynchronous Redis SET command with std::future.
+   * Synchronous Redis GET command with a timeout.
    *
-   * Values will get converted to strings with ctrl_utils::ToString<T>(), or if
-   * a specialization for that type doesn't exist,
-   * std::stringstream::operator<<(). These specializations can be defined
-   * locally for custom types in your code.
-   *
-   * Commands are not sent until RedisClient::commit() is called.
+   * The command is not cancelled on expiry, so its reply is still received
+   * and discarded later.
    *
    * __Example__
    * ~~~~~~~~~~ {.cc}
-   * redis_client.set("key1", 1234);
-   * redis_client.set("key2", 1234);
-   * redis_client.commit();
+   * // Throws std::runtime_error if Redis does not reply within 1ms.
+   * double value = redis_client.sync_get<double>(
+   *     "key", std::chrono::milliseconds(1));
    * ~~~~~~~~~~
    *
    * @param key Redis key.
-   * @param value Redis value.
-   * @return Future Redis reply.
+   * @param timeout Maximum time to wait as a std::chrono::duration, or a
+   *                deadline as a std::chrono::time_point.
+   * @return Redis value.
    */
-  template <typename T>
-  std::future<cpp_redis::reply> set(const std::string& key, const T& value);
+  template <typename T, typename Timeout>
+  T sync_get(const std::string& key, const Timeout& timeout);
 
   /**
-   * Asynchronous Redis SET command with callbacks.
+   * Synchronous Redis GET command with a timeout that keeps the last good
+   * value on failure.
    *
-   * Values will get converted to strings with ctrl_utils::ToString<T>(), or if
-   * a specialization for that type doesn't exist,
+   * The output value is only assigned if the reply arrives and decodes
+   * successfully before the timeout, so a control loop can keep using the
+   * previous value when Redis is slow.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * Eigen::VectorXd q_des = q_init;
+   * while (true) {
+   *   // q_des stays unchanged if Redis does not reply within 500us.
+   *   redis_client.sync_get("q_des", q_des, std::chrono::microseconds(500));
+   * }
+   * ~~~~~~~~~~
+   *
+   * @param key Redis key.
+   * @param value Output value.
+   * @param timeout Maximum time to wait as a std::chrono::duration, or a
+   *                deadline as a std::chrono::time_point.
+   * @return Whether the value was updated.
+   */
+  template <typename T, typename Timeout>
+  bool sync_get(const std::string& key, T& value, const Timeout& timeout);
+
+  /**
+   * Asynchronous Redis SET command with std::future.
+   *
+   * Values will get converted to strings with ctrl_utils::ToString<T>(), or if
+   * a specialization for that type doesn't exist,
+   * std::stringstream::operator<<(). These specializations can be defined
+   * locally for custom types in your code. Eigen matrices are encoded with the
+   * codec selected by RedisClient::set_codec().
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.set("key1", 1234);
+   * redis_client.set("key2", 1234);
+   * redis_client.commit();
+   * ~~~~~~~~~~
+   *
+   * @param key Redis key.
+   * @param value Redis value.
+   * @return Future Redis reply.
+   */
+  template <typename T>
+  std::future<cpp_redis::reply> set(const std::string& key, const T& value);
+
+  /**
+   * Asynchronous Redis SET command with callbacks.
+   *
+   * Values will get converted to strings with ctrl_utils::ToString<T>(), or if
+   * a specialization for that type doesn't exist,
    * std::stringstream::operator<<(). These specializations can be defined
    * locally for custom types in your code.
    *
@@ -276,6 +930,71 @@ class RedisClient : public ::cpp_redis::client {
   template <typename T>
   std::future<std::vector<T>> mget(const std::vector<std::string>& keys);
 
+  /**
+   * Asynchronous Redis MGET command with callbacks for homogeneous value
+   * types.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param keys Redis keys.
+   * @param reply_callback Callback function that gets the values passed in
+   *                       as an Rvalue reference.
+   * @param error_callback Callback function that gets called with the error
+   *                       string when the values cannot be retrieved.
+   * @return RedisClient reference for command chaining.
+   */
+  template <typename T>
+  RedisClient& mget(
+      const std::vector<std::string>& keys,
+      const std::function<void(std::vector<T>&&)>& reply_callback,
+      const std::function<void(const std::string&)>& error_callback = {});
+
+  /**
+   * Asynchronous Redis MGET command with std::future that decodes into
+   * caller-owned values.
+   *
+   * The values are decoded in place, so repeated calls reuse their storage.
+   * With the tensor codec, decoding fixed-size and already-sized Eigen
+   * matrices performs no heap allocation. Each call still allocates the
+   * command with copies of the keys, the promise, and the reply callback, and
+   * cpp_redis copies the command again (see benchmarks/mget_benchmark.cc).
+   * The values must remain valid until the future is ready.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * const std::vector<std::string> keys = {"robot::x_ee", "robot::x_des"};
+   * std::vector<Eigen::Vector3d> values(keys.size());
+   * while (true) {
+   *   std::future<void> fut_values = redis_client.mget(keys, values.data());
+   *   redis_client.commit();
+   *   fut_values.get();
+   * }
+   * ~~~~~~~~~~
+   *
+   * @param keys Redis keys.
+   * @param values Output array with at least keys.size() elements.
+   * @return Future that resolves when the values have been decoded.
+   */
+  template <typename T>
+  std::future<void> mget(const std::vector<std::string>& keys, T* values);
+
+  /**
+   * Asynchronous Redis MGET command with std::future that decodes into a
+   * caller-owned vector.
+   *
+   * The vector is resized to the number of keys if necessary.
+   *
+   * @see RedisClient::mget(const std::vector<std::string>&, T*)
+   */
+  template <typename T>
+  std::future<void> mget(const std::vector<std::string>& keys,
+                         std::vector<T>& values) {
+    values.resize(keys.size());
+    return mget(keys, values.data());
+  }
+
   /**
    * Synchronous Redis MGET command.
    *
@@ -310,6 +1029,35 @@ class RedisClient : public ::cpp_redis::client {
   template <typename T>
   std::vector<T> sync_mget(const std::vector<std::string>& keys);
 
+  /**
+   * Synchronous Redis MGET command for a vector of a single type with a
+   * timeout.
+   *
+   * @param keys Redis keys.
+   * @param timeout Maximum time to wait as a std::chrono::duration, or a
+   *                deadline as a std::chrono::time_point.
+   * @return Redis values in a std::vector.
+   * @see RedisClient::sync_get(const std::string&, const Timeout&)
+   */
+  template <typename T, typename Timeout>
+  std::vector<T> sync_mget(const std::vector<std::string>& keys,
+                           const Timeout& timeout);
+
+  /**
+   * Synchronous Redis MGET command for a vector of a single type with a
+   * timeout that keeps the last good values on failure.
+   *
+   * @param keys Redis keys.
+   * @param values Output values, only assigned on success.
+   * @param timeout Maximum time to wait as a std::chrono::duration, or a
+   *                deadline as a std::chrono::time_point.
+   * @return Whether the values were updated.
+   * @see RedisClient::sync_get(const std::string&, T&, const Timeout&)
+   */
+  template <typename T, typename Timeout>
+  bool sync_mget(const std::vector<std::string>& keys, std::vector<T>& values,
+                 const Timeout& timeout);
+
   // template<class... Ts>
   // RedisClient& mget(const std::array<std::string, sizeof...(Ts)>& keys,
   //                   const std::function<void(std::tuple<Ts...>&&)>
@@ -451,6 +1199,157 @@ class RedisClient : public ::cpp_redis::client {
   cpp_redis::reply sync_hset(const std::string& key, const std::string& field,
                              const T& value);
 
+  /**
+   * Asynchronous Redis HMSET command with std::future.
+   *
+   * Values are encoded with the codec of the hash key.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.hmset("robot::state", std::make_pair("q", q),
+   *                    std::make_pair("dq", dq), std::make_pair("t", t));
+   * redis_client.commit();
+   * ~~~~~~~~~~
+   *
+   * @param key Redis hash key.
+   * @param field_vals Field-value pairs of type std::pair<std::string, T>.
+   * @return Future Redis reply.
+   */
+  template <class... Pairs, typename = is_all_pairs<Pairs...>>
+  std::future<cpp_redis::reply> hmset(const std::string& key,
+                                      const Pairs&... field_vals);
+
+  /**
+   * Asynchronous Redis HMSET command with std::future for homogeneous value
+   * types.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param key Redis hash key.
+   * @param field_vals Vector of field-value pairs.
+   * @return Future Redis reply.
+   */
+  template <typename T>
+  std::future<cpp_redis::reply> hmset(
+      const std::string& key,
+      const std::vector<std::pair<std::string, T>>& field_vals);
+
+  /**
+   * Synchronous Redis HMSET command.
+   *
+   * @param key Redis hash key.
+   * @param field_vals Field-value pairs of type std::pair<std::string, T>.
+   * @return Redis reply.
+   */
+  template <class... Pairs, typename = is_all_pairs<Pairs...>>
+  cpp_redis::reply sync_hmset(const std::string& key,
+                              const Pairs&... field_vals);
+
+  /**
+   * Asynchronous Redis HMGET command with std::future.
+   *
+   * All fields are fetched in one round trip and decoded in one pass.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * std::future<std::tuple<Eigen::VectorXd, double>> fut_state =
+   *     redis_client.hmget<Eigen::VectorXd, double>("robot::state", "q", "t");
+   * redis_client.commit();
+   * const auto [q, t] = fut_state.get();
+   * ~~~~~~~~~~
+   *
+   * @param key Redis hash key.
+   * @param fields Hash fields.
+   * @return Future field values packed into a std::tuple.
+   */
+  template <class... Ts, class... Strings,
+            typename = is_all_strings<Strings...>>
+  std::future<std::tuple<Ts...>> hmget(const std::string& key,
+                                       const Strings&... fields);
+
+  /**
+   * Asynchronous Redis HMGET command with std::future that decodes the fields
+   * into the given references.
+   *
+   * Use std::tie() to decode the fields directly into the members of a
+   * struct. The references must remain valid until the future is ready.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * struct RobotState {
+   *   Eigen::VectorXd q;
+   *   Eigen::VectorXd dq;
+   *   double t;
+   * } state;
+   * std::future<void> fut_state = redis_client.hmget(
+   *     "robot::state", std::tie(state.q, state.dq, state.t), "q", "dq", "t");
+   * redis_client.commit();
+   * fut_state.wait();
+   * ~~~~~~~~~~
+   *
+   * @param key Redis hash key.
+   * @param values Tuple of references to the output values.
+   * @param fields Hash fields in the same order as the values.
+   * @return Future that resolves when the values have been decoded.
+   */
+  template <class... Ts, class... Strings,
+            typename = is_all_strings<Strings...>>
+  std::future<void> hmget(const std::string& key, std::tuple<Ts&...> values,
+                          const Strings&... fields);
+
+  /**
+   * Synchronous Redis HMGET command.
+   *
+   * @param key Redis hash key.
+   * @param fields Hash fields.
+   * @return Field values in a std::tuple.
+   */
+  template <class... Ts, class... Strings,
+            typename = is_all_strings<Strings...>>
+  std::tuple<Ts...> sync_hmget(const std::string& key,
+                               const Strings&... fields);
+
+  /**
+   * Synchronous Redis HMGET command that decodes the fields into the given
+   * references.
+   *
+   * @param key Redis hash key.
+   * @param values Tuple of references to the output values.
+   * @param fields Hash fields in the same order as the values.
+   */
+  template <class... Ts, class... Strings,
+            typename = is_all_strings<Strings...>>
+  void sync_hmget(const std::string& key, std::tuple<Ts&...> values,
+                  const Strings&... fields);
+
+  /**
+   * Asynchronous Redis HGETALL command with std::future for homogeneous value
+   * types.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param key Redis hash key.
+   * @return Future map from hash fields to values.
+   */
+  template <typename T>
+  std::future<std::unordered_map<std::string, T>> hgetall(
+      const std::string& key);
+
+  /**
+   * Synchronous Redis HGETALL command for homogeneous value types.
+   *
+   * @param key Redis hash key.
+   * @return Map from hash fields to values.
+   */
+  template <typename T>
+  std::unordered_map<std::string, T> sync_hgetall(const std::string& key);
+
   template <typename T>
   RedisClient& publish(const std::string& key, const T& value,
                        const reply_callback_t& reply_callback);
@@ -461,459 +1360,3113 @@ class RedisClient : public ::cpp_redis::client {
   template <typename T>
   cpp_redis::reply sync_publish(const std::string& key, const T& value);
 
-  template <typename TSub, typename TPub>
-  RedisClient& request(const std::string& key_pub, const TPub& value_pub,
-                       const std::string& key_sub,
-                       std::function<void(TSub&&)>&& sub_callback);
-
-  template <typename TSub, typename TPub>
-  std::future<TSub> request(const std::string& key_pub, const TPub& value_pub,
-                            const std::string& key_sub);
+  /**
+   * Publishes values to many channels as one pipelined batch.
+   *
+   * The commands are encoded into reused buffers, share a single reply
+   * handler, and are counted towards the pipeline policy once for the whole
+   * batch, so the batch is never split by an automatic commit.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.publish_many(std::make_pair("robot::q", q),
+   *                           std::make_pair("robot::dq", dq),
+   *                           std::make_pair("robot::t", t));
+   * redis_client.commit();
+   * ~~~~~~~~~~
+   *
+   * @param channel_vals (channel, value) pairs with any value types.
+   * @return Future total number of subscribers that received the messages.
+   */
+  template <class... Pairs, typename = is_all_pairs<Pairs...>>
+  std::future<size_t> publish_many(const Pairs&... channel_vals);
 
-  template <typename TSub, typename TPub>
-  TSub sync_request(const std::string& key_pub, const TPub& value_pub,
-                    const std::string& key_sub);
+  /**
+   * Publishes values to many channels as one pipelined batch for homogeneous
+   * value types.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param channel_vals Vector of (channel, value) pairs.
+   * @return Future total number of subscribers that received the messages.
+   */
+  template <typename T>
+  std::future<size_t> publish_many(
+      const std::vector<std::pair<std::string, T>>& channel_vals);
 
-  RedisClient& scan(
-      const std::string& pattern,
-      std::function<void(std::unordered_set<std::string>&&)>&& callback);
+  /**
+   * Synchronous publish_many() for any value types.
+   */
+  template <class... Pairs, typename = is_all_pairs<Pairs...>>
+  size_t sync_publish_many(const Pairs&... channel_vals);
 
-  std::future<std::unordered_set<std::string>> scan(const std::string& pattern);
+  /**
+   * Synchronous publish_many() for homogeneous value types.
+   */
+  template <typename T>
+  size_t sync_publish_many(
+      const std::vector<std::pair<std::string, T>>& channel_vals);
 
-  std::unordered_set<std::string> sync_scan(const std::string& pattern);
+  /**
+   * Subscribes to a channel with a decoded callback.
+   *
+   * Messages are decoded and delivered on the subscriber thread pool (see
+   * set_subscriber_threads()) rather than on the network thread, so a slow
+   * callback doesn't back up the subscriber connection. Messages of one
+   * subscription are delivered one at a time and in order. Different
+   * subscriptions run in parallel if the pool has several threads.
+   *
+   * This function blocks until the subscription is acknowledged.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.subscribe<Eigen::VectorXd>(
+   *     "robot::q",
+   *     [](Eigen::VectorXd&& q) { std::cout << q.transpose() << std::endl; },
+   *     ctrl_utils::RedisClient::SubscriptionMode::kLatest);
+   * ~~~~~~~~~~
+   *
+   * @param channel Redis channel.
+   * @param callback Callback with the decoded message.
+   * @param mode Whether to deliver every message or only the latest.
+   * @param error_callback Called if decoding or the callback throws.
+   * @return RedisClient reference for command chaining.
+   */
+  template <typename T>
+  RedisClient& subscribe(
+      const std::string& channel, std::function<void(T&&)> callback,
+      SubscriptionMode mode = SubscriptionMode::kQueue,
+      std::function<void(const std::string&)> error_callback = {});
 
- private:
+  /**
+   * Subscribes to channels matching a glob pattern with a decoded callback.
+   *
+   * Delivery works as in subscribe().
+   *
+   * @param pattern Redis glob pattern of channels.
+   * @param callback Callback with the channel and the decoded message.
+   * @param mode Whether to deliver every message or only the latest.
+   * @param error_callback Called if decoding or the callback throws.
+   * @return RedisClient reference for command chaining.
+   */
   template <typename T>
-  static bool ReplyToString(const cpp_redis::reply& reply, T& value);
+  RedisClient& psubscribe(
+      const std::string& pattern,
+      std::function<void(const std::string&, T&&)> callback,
+      SubscriptionMode mode = SubscriptionMode::kQueue,
+      std::function<void(const std::string&)> error_callback = {});
 
-  template <typename Tuple, size_t... Is>
-  static void RepliesToTuple(const std::vector<cpp_redis::reply>& replies,
-                             Tuple& values, std::index_sequence<Is...>);
+  /**
+   * Removes the subscribe() callbacks of the channel. Pending request() calls
+   * on the channel are unaffected, and the subscriber unsubscribes from the
+   * channel once they are done.
+   */
+  RedisClient& unsubscribe(const std::string& channel);
 
-  template <typename Key, typename Val, typename = is_string<Key>>
-  static bool KeyvalToString(const std::pair<Key, Val>& key_val,
-                             std::pair<std::string, std::string>& key_valstr);
+  /**
+   * Removes the psubscribe() callbacks of the pattern and unsubscribes the
+   * subscriber from it.
+   */
+  RedisClient& punsubscribe(const std::string& pattern);
 
-  template <typename Tuple, size_t... Is>
-  static void KeyvalsToString(
-      const Tuple& args,
-      std::vector<std::pair<std::string, std::string>>& key_valstr,
-      std::index_sequence<Is...>);
+  /**
+   * Sets the number of threads that deliver subscription messages. Must be
+   * called before the first subscribe() or psubscribe().
+   *
+   * @param num_threads Number of threads, or 0 for the number of hardware
+   *                    threads. The default is 1.
+   */
+  void set_subscriber_threads(size_t num_threads) {
+    std::unique_lock<std::mutex> lock(mtx_channels_);
+    if (subscriber_pool_) {
+      throw std::runtime_error(
+          "RedisClient::set_subscriber_threads(): Subscriber threads are "
+          "already running.");
+    }
+    num_subscriber_threads_ = num_threads;
+  }
 
-  RedisClient& scan(
-      size_t cursor, const std::string& pattern,
-      std::unordered_set<std::string>&& keys,
-      std::function<void(std::unordered_set<std::string>&&)>&& callback);
+  /**
+   * Sets how long a timed out sync_request() keeps its place in the response
+   * order of the channel, so that its late response is discarded instead of
+   * being passed to the next request.
+   *
+   * @param timeout Time after the request times out. The default is 1s.
+   */
+  template <typename Rep, typename Period>
+  void set_late_response_timeout(
+      const std::chrono::duration<Rep, Period>& timeout) {
+    std::unique_lock<std::mutex> lock(mtx_channels_);
+    late_response_timeout_ =
+        std::chrono::duration_cast<Clock::duration>(timeout);
+  }
 
-  std::string host_;
-  std::size_t port_;
-};
+  /**
+   * Asynchronous request/response over Redis pub/sub with callbacks.
+   *
+   * Publishes the request value to key_pub and passes the next message
+   * received on key_sub to the callback. Responses are received on a single
+   * subscriber connection that persists for the lifetime of the client. Each
+   * response channel is subscribed to once, and concurrent requests on the
+   * same channel are matched to responses in the order they were made.
+   *
+   * The first request on a new response channel blocks until the subscription
+   * is acknowledged so that the response cannot be missed.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.request<std::string>("plan::request", goal, "plan::response",
+   *                                   [](std::string&& plan) {
+   *   std::cout << "Plan: " << plan << std::endl;
+   * });
+   * redis_client.commit();
+   * ~~~~~~~~~~
+   *
+   * @param key_pub Redis channel to publish the request to.
+   * @param value_pub Request value.
+   * @param key_sub Redis channel to receive the response from.
+   * @param sub_callback Callback function that gets the response value passed
+   *                     in as an Rvalue reference.
+   * @param error_callback Callback function that gets called with the error
+   *                       string when the response cannot be decoded.
+   * @return RedisClient reference for command chaining.
+   */
+  template <typename TSub, typename TPub>
+  RedisClient& request(
+      const std::string& key_pub, const TPub& value_pub,
+      const std::string& key_sub, std::function<void(TSub&&)>&& sub_callback,
+      std::function<void(const std::string&)>&& error_callback = {});
+
+  /**
+   * Asynchronous request/response over Redis pub/sub with std::future.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param key_pub Redis channel to publish the request to.
+   * @param value_pub Request value.
+   * @param key_sub Redis channel to receive the response from.
+   * @return Future response value.
+   */
+  template <typename TSub, typename TPub>
+  std::future<TSub> request(const std::string& key_pub, const TPub& value_pub,
+                            const std::string& key_sub);
+
+  /**
+   * Synchronous request/response over Redis pub/sub.
+   *
+   * @param key_pub Redis channel to publish the request to.
+   * @param value_pub Request value.
+   * @param key_sub Redis channel to receive the response from.
+   * @return Response value.
+   */
+  template <typename TSub, typename TPub>
+  TSub sync_request(const std::string& key_pub, const TPub& value_pub,
+                    const std::string& key_sub);
+
+  /**
+   * Synchronous request/response over Redis pub/sub with a timeout.
+   *
+   * The timeout also bounds the wait for the subscription to a new response
+   * channel. Responses carry no request ID, so they are matched to requests
+   * in order. A request that times out keeps its place for the late response
+   * timeout (see set_late_response_timeout()) and discards the next response
+   * that arrives in that window. A response that arrives later than that, or
+   * one that is never sent, shifts the responses of the requests made in the
+   * meantime by one.
+   *
+   * @param key_pub Redis channel to publish the request to.
+   * @param value_pub Request value.
+   * @param key_sub Redis channel to receive the response from.
+   * @param timeout Maximum time to wait as a std::chrono::duration, or a
+   *                deadline as a std::chrono::time_point.
+   * @return Response value.
+   */
+  template <typename TSub, typename TPub, typename Timeout>
+  TSub sync_request(const std::string& key_pub, const TPub& value_pub,
+                    const std::string& key_sub, const Timeout& timeout);
+
+  /**
+   * Synchronous request/response over Redis pub/sub with a timeout that keeps
+   * the last good response on failure. Timeouts are handled as in the
+   * throwing overload.
+   *
+   * @param key_pub Redis channel to publish the request to.
+   * @param value_pub Request value.
+   * @param key_sub Redis channel to receive the response from.
+   * @param value_sub Output response, only assigned on success.
+   * @param timeout Maximum time to wait as a std::chrono::duration, or a
+   *                deadline as a std::chrono::time_point.
+   * @return Whether the response was updated.
+   */
+  template <typename TSub, typename TPub, typename Timeout>
+  bool sync_request(const std::string& key_pub, const TPub& value_pub,
+                    const std::string& key_sub, TSub& value_sub,
+                    const Timeout& timeout);
+
+  /**
+   * Asynchronous Redis XADD command with std::future.
+   *
+   * Appends one entry with the given field-value pairs to the stream. Values
+   * are encoded with the codec of the stream key.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.xadd("robot::log", std::make_pair("q", q),
+   *                   std::make_pair("dq", dq), std::make_pair("t", t));
+   * redis_client.commit();
+   * ~~~~~~~~~~
+   *
+   * @param key Redis stream key.
+   * @param field_vals Field-value pairs of type std::pair<std::string, T>.
+   * @return Future id of the new entry.
+   */
+  template <class... Pairs, typename = is_all_pairs<Pairs...>>
+  std::future<std::string> xadd(const std::string& key,
+                                const Pairs&... field_vals);
+
+  /**
+   * Asynchronous Redis XADD command with std::future for homogeneous value
+   * types.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param key Redis stream key.
+   * @param field_vals Vector of field-value pairs.
+   * @param max_len Approximate maximum length of the stream (MAXLEN ~), or 0
+   *                for an unbounded stream.
+   * @return Future id of the new entry.
+   */
+  template <typename T>
+  std::future<std::string> xadd(
+      const std::string& key,
+      const std::vector<std::pair<std::string, T>>& field_vals,
+      size_t max_len = 0);
+
+  /**
+   * Synchronous Redis XADD command.
+   *
+   * @param key Redis stream key.
+   * @param field_vals Field-value pairs of type std::pair<std::string, T>.
+   * @return Id of the new entry.
+   */
+  template <class... Pairs, typename = is_all_pairs<Pairs...>>
+  std::string sync_xadd(const std::string& key, const Pairs&... field_vals);
+
+  /**
+   * Asynchronous Redis XRANGE command with std::future.
+   *
+   * All field values of the returned entries are decoded as type T. Use
+   * std::string to decode fields of different types separately.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * std::future<std::vector<RedisClient::StreamEntry<Eigen::VectorXd>>>
+   *     fut_entries = redis_client.xrange<Eigen::VectorXd>("robot::log");
+   * redis_client.commit();
+   * for (const auto& entry : fut_entries.get()) {
+   *   std::cout << entry.id << ": " << entry.fields[0].second << std::endl;
+   * }
+   * ~~~~~~~~~~
+   *
+   * @param key Redis stream key.
+   * @param start Id of the first entry ("-" for the beginning of the stream).
+   * @param end Id of the last entry ("+" for the end of the stream).
+   * @param count Maximum number of entries, or 0 for all entries.
+   * @return Future entries in increasing id order.
+   */
+  template <typename T>
+  std::future<std::vector<StreamEntry<T>>> xrange(
+      const std::string& key, const std::string& start = "-",
+      const std::string& end = "+", size_t count = 0);
+
+  /**
+   * Asynchronous Redis XREVRANGE command with std::future.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param key Redis stream key.
+   * @param end Id of the first returned entry ("+" for the end of the stream).
+   * @param start Id of the last returned entry ("-" for the beginning).
+   * @param count Maximum number of entries, or 0 for all entries.
+   * @return Future entries in decreasing id order.
+   */
+  template <typename T>
+  std::future<std::vector<StreamEntry<T>>> xrevrange(
+      const std::string& key, const std::string& end = "+",
+      const std::string& start = "-", size_t count = 0);
+
+  /**
+   * Synchronous Redis XRANGE command.
+   *
+   * @param key Redis stream key.
+   * @param start Id of the first entry ("-" for the beginning of the stream).
+   * @param end Id of the last entry ("+" for the end of the stream).
+   * @param count Maximum number of entries, or 0 for all entries.
+   * @return Entries in increasing id order.
+   */
+  template <typename T>
+  std::vector<StreamEntry<T>> sync_xrange(const std::string& key,
+                                          const std::string& start = "-",
+                                          const std::string& end = "+",
+                                          size_t count = 0);
+
+  /**
+   * Asynchronous Redis XREAD command with std::future.
+   *
+   * Returns the entries after the given id. With a positive block timeout,
+   * the server holds the reply until an entry arrives or the timeout expires,
+   * which also delays all later commands on this connection. Blocking reads
+   * should therefore use a dedicated RedisClient.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param key Redis stream key.
+   * @param id Id after which to read entries ("$" for new entries only).
+   * @param count Maximum number of entries, or 0 for all entries.
+   * @param block Time to wait for new entries. Zero returns immediately and
+   *              std::chrono::milliseconds::max() waits indefinitely.
+   * @return Future entries in increasing id order, or an empty vector if the
+   *         timeout expired.
+   */
+  template <typename T>
+  std::future<std::vector<StreamEntry<T>>> xread(
+      const std::string& key, const std::string& id, size_t count = 0,
+      std::chrono::milliseconds block = std::chrono::milliseconds::zero());
+
+  /**
+   * Synchronous Redis XREAD command.
+   *
+   * @see RedisClient::xread()
+   */
+  template <typename T>
+  std::vector<StreamEntry<T>> sync_xread(
+      const std::string& key, const std::string& id, size_t count = 0,
+      std::chrono::milliseconds block = std::chrono::milliseconds::zero());
+
+  /**
+   * Registers a Lua script to be run with RedisClient::evalsha().
+   *
+   * The script is loaded into the server's script cache with SCRIPT LOAD, and
+   * its SHA1 digest is cached in the client. This function blocks until the
+   * script is loaded.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * // Add an offset to a counter and return the new value in one round trip.
+   * redis_client.register_script("add_offset", R"(
+   *   local value = tonumber(redis.call('GET', KEYS[1])) + tonumber(ARGV[1])
+   *   redis.call('SET', KEYS[1], value)
+   *   return tostring(value)
+   * )");
+   * double value = redis_client.sync_evalsha<double>("add_offset", {"x"}, 0.5);
+   * ~~~~~~~~~~
+   *
+   * @param name Name of the script.
+   * @param source Lua source code.
+   * @return SHA1 digest of the script.
+   */
+  std::string register_script(const std::string& name,
+                              const std::string& source);
+
+  /**
+   * Asynchronous Redis EVALSHA command with std::future that runs a
+   * registered script.
+   *
+   * Arguments are encoded with the default codec. If the server has flushed
+   * its script cache, the script is rerun with EVAL, which loads it again.
+   *
+   * The result is decoded from a string or integer reply. Use
+   * cpp_redis::reply as the result type to get the raw reply.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param name Name of the script registered with register_script().
+   * @param keys Redis keys accessed by the script (KEYS).
+   * @param args Script arguments (ARGV).
+   * @return Future script result.
+   */
+  template <typename TResult, class... Args>
+  std::future<TResult> evalsha(const std::string& name,
+                               const std::vector<std::string>& keys,
+                               const Args&... args);
+
+  /**
+   * Synchronous Redis EVALSHA command that runs a registered script.
+   *
+   * @see RedisClient::evalsha()
+   */
+  template <typename TResult, class... Args>
+  TResult sync_evalsha(const std::string& name,
+                       const std::vector<std::string>& keys,
+                       const Args&... args);
+
+  /**
+   * Asynchronous Redis SCAN command that streams keys in batches.
+   *
+   * Each batch of keys is passed to the batch callback as soon as it arrives.
+   * The request for the next batch is sent before the callback is called, so
+   * processing overlaps with the next round trip. Keys may be returned more
+   * than once if the database is modified during the scan.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * __Example__
+   * ~~~~~~~~~~ {.cc}
+   * redis_client.scan("robot::*", 1000, "string",
+   *                   [](std::vector<std::string>&& keys) {
+   *   for (const std::string& key : keys) std::cout << key << std::endl;
+   * }, []() {
+   *   std::cout << "Done." << std::endl;
+   * });
+   * redis_client.commit();
+   * ~~~~~~~~~~
+   *
+   * @param pattern Redis glob pattern.
+   * @param count COUNT hint for the number of keys examined per batch, or 0
+   *              for the server default.
+   * @param type Only return keys of this Redis type (e.g. "string" or "hash"),
+   *             or an empty string for all types. Requires Redis 6.
+   * @param batch_callback Callback function that gets each non-empty batch of
+   *                       keys passed in as an Rvalue reference.
+   * @param done_callback Callback function that gets called after the last
+   *                      batch.
+   * @param error_callback Callback function that gets called with the error
+   *                       string when the scan has failed.
+   * @return RedisClient reference for command chaining.
+   */
+  RedisClient& scan(
+      const std::string& pattern, size_t count, const std::string& type,
+      std::function<void(std::vector<std::string>&&)>&& batch_callback,
+      std::function<void()>&& done_callback = {},
+      std::function<void(const std::string&)>&& error_callback = {});
+
+  /**
+   * Asynchronous Redis SCAN command with callbacks that collects all keys.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param pattern Redis glob pattern.
+   * @param callback Callback function that gets the set of keys passed in as
+   *                 an Rvalue reference.
+   * @param error_callback Callback function that gets called with the error
+   *                       string when the scan has failed.
+   * @return RedisClient reference for command chaining.
+   */
+  RedisClient& scan(
+      const std::string& pattern,
+      std::function<void(std::unordered_set<std::string>&&)>&& callback,
+      std::function<void(const std::string&)>&& error_callback = {});
+
+  /**
+   * Asynchronous Redis SCAN command with std::future that collects all keys.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @param pattern Redis glob pattern.
+   * @return Future set of keys.
+   */
+  std::future<std::unordered_set<std::string>> scan(const std::string& pattern);
+
+  /**
+   * Synchronous Redis SCAN command that collects all keys.
+   *
+   * @param pattern Redis glob pattern.
+   * @return Set of keys.
+   */
+  std::unordered_set<std::string> sync_scan(const std::string& pattern);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Sends a command and counts it towards the pipeline policy.
+   */
+  RedisClient& Send(const std::vector<std::string>& command,
+                    const reply_callback_t& reply_callback);
+
+  /**
+   * Sends a command and counts it towards the pipeline policy.
+   */
+  std::future<cpp_redis::reply> Send(const std::vector<std::string>& command);
+
+  /**
+   * Queues a command without checking the pipeline policy. Buffered writes
+   * are queued first.
+   */
+  void Queue(const std::vector<std::string>& command,
+             const reply_callback_t& reply_callback);
+
+  /**
+   * Queues a command without flushing buffered writes.
+   */
+  void QueueUnbuffered(const std::vector<std::string>& command,
+                       const reply_callback_t& reply_callback);
+
+  /**
+   * Returns the command with the keys as its arguments.
+   */
+  static std::vector<std::string> KeysCommand(
+      const std::string& name, const std::vector<std::string>& keys);
+
+  /**
+   * Counts queued commands towards the pipeline policy.
+   *
+   * @return Whether a limit of the pipeline policy is reached.
+   */
+  bool CountPending(size_t num_commands, size_t num_bytes);
+
+  /**
+   * Returns whether a limit of the pipeline policy is reached. Must be called
+   * with mtx_pipeline_ locked.
+   */
+  bool IsPipelineDue() const;
+
+  /**
+   * Aggregates the replies of a publish_many() batch. Replies are handled in
+   * order on the cpp_redis reply thread.
+   */
+  class PublishBatch {
+   public:
+    explicit PublishBatch(size_t num_commands)
+        : num_remaining_(num_commands) {}
+
+    std::future<size_t> get_future() { return promise_.get_future(); }
+
+    void OnReply(const cpp_redis::reply& reply);
+
+    /**
+     * Sets the result after all the replies have been received.
+     */
+    void Complete();
+
+   private:
+    std::promise<size_t> promise_;
+    size_t num_remaining_;
+    size_t num_receivers_ = 0;
+    std::string error_;
+  };
+
+  /**
+   * Encodes a PUBLISH command into the reused command buffer and queues it.
+   */
+  template <typename T>
+  void QueuePublish(const std::string& channel, const T& value,
+                    const reply_callback_t& reply_callback,
+                    std::vector<std::string>& command, size_t& num_bytes);
+
+  /**
+   * Counts a queued publish_many() batch towards the pipeline policy.
+   */
+  void FinishPublishBatch(size_t num_commands, size_t num_bytes,
+                          PublishBatch& batch);
+
+  /**
+   * Returns the number of bytes of the RESP-encoded command.
+   */
+  static size_t CommandSize(const std::vector<std::string>& command);
+
+  /**
+   * Returns the number of bytes of the RESP-encoded reply.
+   */
+  static size_t ReplySize(const cpp_redis::reply& reply);
+
+  /**
+   * Wraps the reply callback to record the command in the instrumentation.
+   */
+  reply_callback_t InstrumentCallback(const std::vector<std::string>& command,
+                                      const reply_callback_t& reply_callback);
+
+  template <typename T>
+  std::string Encode(const std::string& key, const T& value) const;
+
+  template <typename T>
+  void Encode(const std::string& key, const T& value, std::string& str) const;
+
+  template <typename T>
+  static T Decode(const std::string& str);
+
+  /**
+   * Compresses the encoded value according to the compression settings of the
+   * key. Values without a key (script arguments) are never compressed.
+   */
+  void CompressValue(const std::string& key, std::string& str) const;
+
+  static void CheckCompression(Compression compression) {
+    if (!IsCompressionAvailable(compression)) {
+      throw std::invalid_argument(
+          "RedisClient::set_compression(): Compression algorithm is not "
+          "compiled in.");
+    }
+  }
+
+  template <typename T>
+  static void Decode(const std::string& str, T& value);
+
+  template <typename T>
+  static bool ReplyToString(const cpp_redis::reply& reply, T& value);
+
+  /**
+   * Waits for the future until the timeout duration has elapsed. Returns
+   * whether the future is ready.
+   */
+  template <typename Future, class Rep, class Period>
+  static bool WaitFor(const Future& future,
+                      const std::chrono::duration<Rep, Period>& timeout) {
+    return future.wait_for(timeout) == std::future_status::ready;
+  }
+
+  /**
+   * Waits for the future until the deadline. Returns whether the future is
+   * ready.
+   */
+  template <typename Future, class TimeClock, class Duration>
+  static bool WaitFor(
+      const Future& future,
+      const std::chrono::time_point<TimeClock, Duration>& deadline) {
+    return future.wait_until(deadline) == std::future_status::ready;
+  }
+
+  /**
+   * Converts the timeout duration to a deadline so that it can bound several
+   * waits in sequence.
+   */
+  template <class Rep, class Period>
+  static std::chrono::steady_clock::time_point ToDeadline(
+      const std::chrono::duration<Rep, Period>& timeout) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point now = Clock::now();
+    if (timeout >= Clock::time_point::max() - now) {
+      return Clock::time_point::max();
+    }
+    return now + std::chrono::duration_cast<Clock::duration>(timeout);
+  }
+
+  template <class TimeClock, class Duration>
+  static std::chrono::time_point<TimeClock, Duration> ToDeadline(
+      const std::chrono::time_point<TimeClock, Duration>& deadline) {
+    return deadline;
+  }
+
+  /**
+   * Gets the value of a ready future. Returns false if it holds an exception.
+   */
+  template <typename T>
+  static bool TryGet(std::future<T>& future, T& value) {
+    try {
+      value = future.get();
+    } catch (const std::exception&) {
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Formats the error message for a failed MGET.
+   */
+  template <typename Iterator>
+  static std::string MgetError(Iterator it_key, Iterator it_end);
+
+  template <typename Tuple, size_t... Is>
+  static void RepliesToTuple(const std::vector<cpp_redis::reply>& replies,
+                             Tuple& values, std::index_sequence<Is...>);
+
+  template <typename Key, typename Val, typename = is_string<Key>>
+  bool KeyvalToString(const std::pair<Key, Val>& key_val,
+                      std::pair<std::string, std::string>& key_valstr) const;
+
+  template <typename Tuple, size_t... Is>
+  void KeyvalsToString(
+      const Tuple& args,
+      std::vector<std::pair<std::string, std::string>>& key_valstr,
+      std::index_sequence<Is...>) const;
+
+  /**
+   * Appends the encoded field-value pair to the XADD command.
+   */
+  template <typename Field, typename T>
+  void AppendField(const std::string& key,
+                   const std::pair<Field, T>& field_val,
+                   std::vector<std::string>& command) const;
+
+  /**
+   * Sends an XADD command and returns the future entry id.
+   */
+  std::future<std::string> SendXadd(const std::vector<std::string>& command);
+
+  /**
+   * Sends a command that returns stream entries.
+   *
+   * XRANGE and XREVRANGE reply with an array of entries. XREAD replies with
+   * an array of [key, entries] pairs, or null if it timed out.
+   */
+  template <typename T>
+  std::future<std::vector<StreamEntry<T>>> SendStreamRead(
+      const std::vector<std::string>& command, bool is_xread);
+
+  /**
+   * Decodes an array of [id, [field, value, ...]] stream entries.
+   */
+  template <typename T>
+  static std::vector<StreamEntry<T>> DecodeStreamEntries(
+      const std::vector<cpp_redis::reply>& replies);
+
+  /**
+   * Lua script registered with register_script().
+   */
+  struct Script {
+    std::string source;
+    std::string sha;
+  };
+
+  /**
+   * Decodes a script result from a string or integer reply.
+   */
+  template <typename T>
+  static T DecodeScriptResult(const cpp_redis::reply& reply);
+
+  /**
+   * State of a streaming SCAN.
+   */
+  struct ScanState {
+    std::string pattern;
+    size_t count;
+    std::string type;
+    std::function<void(std::vector<std::string>&&)> batch_callback;
+    std::function<void()> done_callback;
+    std::function<void(const std::string&)> error_callback;
+  };
+
+  /**
+   * Requests the batch of keys at the SCAN cursor.
+   */
+  void ScanCursor(const std::string& cursor,
+                  const std::shared_ptr<ScanState>& state);
+
+  /**
+   * Messages of one subscribe() or psubscribe() call waiting for delivery.
+   */
+  struct Subscription {
+    /// Decodes the message and calls the user callback.
+    std::function<void(const std::string&, const std::string&)> deliver;
+
+    SubscriptionMode mode = SubscriptionMode::kQueue;
+
+    std::mutex mtx;
+
+    /// Pending (channel, message) pairs.
+    std::deque<std::pair<std::string, std::string>> messages;
+
+    /// Whether a delivery job is queued or running on the thread pool.
+    bool is_scheduled = false;
+  };
+
+  struct PendingRequest {
+    uint64_t id;
+
+    /// Response callback, or empty if the request has timed out.
+    std::function<void(const std::string&)> callback;
+
+    /// Time after which a timed out request stops waiting for its response.
+    Clock::time_point expiry = Clock::time_point::max();
+  };
+
+  /**
+   * Pub/sub state of a channel on the persistent subscriber.
+   */
+  struct Channel {
+    /// Resolves when the subscription has been acknowledged.
+    std::shared_future<void> subscribed;
+
+    /// Pending requests in the order they were made.
+    std::deque<PendingRequest> requests;
+
+    /// Subscriptions from subscribe() or psubscribe().
+    std::vector<std::shared_ptr<Subscription>> subscriptions;
+
+    /// Whether unsubscribe() or punsubscribe() was called. The subscriber
+    /// unsubscribes once no subscriptions or pending requests remain.
+    bool is_unsubscribed = false;
+
+    /**
+     * Returns whether no subscriptions or pending requests remain.
+     */
+    bool IsIdle() const {
+      return subscriptions.empty() &&
+             std::none_of(requests.begin(), requests.end(),
+                          [](const PendingRequest& request) {
+                            return static_cast<bool>(request.callback);
+                          });
+    }
+
+    /**
+     * Drops timed out requests whose late responses are no longer awaited.
+     */
+    void DropExpiredRequests(Clock::time_point now) {
+      requests.erase(std::remove_if(requests.begin(), requests.end(),
+                                    [now](const PendingRequest& request) {
+                                      return !request.callback &&
+                                             request.expiry <= now;
+                                    }),
+                     requests.end());
+    }
+  };
+
+  /**
+   * Subscribes the persistent subscriber to the channel or pattern if
+   * necessary. Must be called with mtx_subscriber_ locked and mtx_channels_
+   * unlocked.
+   *
+   * @return Future that resolves when the subscription is acknowledged.
+   */
+  std::shared_future<void> SubscribeChannel(const std::string& channel,
+                                            bool is_pattern);
+
+  /**
+   * Unsubscribes the persistent subscriber from the channel or pattern if
+   * unsubscribe() or punsubscribe() was called and it is idle. Must be called
+   * with mtx_subscriber_ locked and mtx_channels_ unlocked, and not from a
+   * subscriber callback.
+   */
+  void UnsubscribeChannel(const std::string& channel, bool is_pattern);
+
+  /**
+   * Creates the subscriber thread pool on first use. Must be called with
+   * mtx_channels_ locked.
+   */
+  ThreadPool<void>& SubscriberPool();
+
+  /**
+   * Registers the subscription and waits until it is acknowledged.
+   */
+  void AddSubscription(const std::string& channel, bool is_pattern,
+                       std::shared_ptr<Subscription>&& subscription);
+
+  /**
+   * Queues the message on the subscription and schedules its delivery.
+   */
+  void Dispatch(const std::shared_ptr<Subscription>& subscription,
+                const std::string& channel, const std::string& message);
+
+  /**
+   * Delivers the messages queued on the subscription. Runs on the subscriber
+   * thread pool.
+   */
+  void Deliver(const std::shared_ptr<Subscription>& subscription);
+
+  /**
+   * Dispatches a message received on a psubscribe() pattern.
+   */
+  void OnPatternMessage(const std::string& pattern, const std::string& channel,
+                        const std::string& message);
+
+  /**
+   * Connects the persistent subscriber on first use. Must be called with
+   * mtx_subscriber_ locked.
+   */
+  cpp_redis::subscriber& ConnectSubscriber();
+
+  /**
+   * Looks up the key in the read cache.
+   *
+   * On a hit, copies the cached value and returns true. On a miss of a
+   * cacheable key, sets cache_epoch to the current nonzero cache epoch.
+   */
+  template <typename T>
+  bool GetCached(const std::string& key, T& value, uint64_t& cache_epoch);
+
+  /**
+   * Stores the value in the read cache if no cached key has been invalidated
+   * since cache_epoch.
+   */
+  template <typename T>
+  void SetCached(const std::string& key, const T& value, uint64_t cache_epoch);
+
+  /**
+   * Removes the key from the read cache if it is cacheable.
+   */
+  void InvalidateCache(const std::string& key);
+
+  /**
+   * Replaces the encoded value with a shared-memory handle if the key is
+   * transferred through shared memory.
+   */
+  void WriteSharedMemory(const std::string& key, std::string& str);
+
+  /**
+   * Buffers the encoded value if the key is written back on commit, and
+   * commits if the pipeline policy is due.
+   *
+   * @return Whether the value was buffered, in which case str holds the
+   *         previously buffered value.
+   */
+  bool WriteBack(const std::string& key, std::string& str,
+                 const reply_callback_t& reply_callback);
+
+  /**
+   * Decodes the buffered value of the key if it has one.
+   */
+  template <typename T>
+  bool GetWriteBack(const std::string& key, T& value);
+
+  /**
+   * Queues the buffered values as a single MSET.
+   */
+  void FlushWriteBack();
+
+  /**
+   * Returns whether the string is a shared-memory handle.
+   */
+  static bool IsSharedMemoryHandle(const std::string& str) {
+    return str.compare(0, kSharedMemoryPrefix.size(), kSharedMemoryPrefix) ==
+           0;
+  }
+
+  /**
+   * Copies the value referenced by a shared-memory handle.
+   */
+  static void ReadSharedMemory(const std::string& handle, std::string& str);
+
+  /**
+   * Returns the host name used to check that handles are readable.
+   */
+  static const std::string& HostName();
+
+  /**
+   * Registers a callback for the next message on the channel, subscribing to
+   * the channel on the persistent subscriber if necessary.
+   *
+   * The request should not be published until the subscription is
+   * acknowledged, or the response may be missed.
+   *
+   * @param subscribed Output future that resolves when the subscription is
+   *                   acknowledged.
+   * @return Request ID for CancelRequest().
+   */
+  uint64_t AddRequest(const std::string& channel,
+                      std::function<void(const std::string&)>&& callback,
+                      std::shared_future<void>& subscribed);
+
+  /**
+   * Marks a pending request as timed out. Its entry absorbs the next message
+   * on the channel, and it is removed when the next request is made.
+   */
+  void CancelRequest(const std::string& channel, uint64_t request_id);
+
+  /**
+   * Creates a request callback that resolves the promise.
+   */
+  template <typename TSub>
+  static std::function<void(const std::string&)> ResolveRequest(
+      const std::shared_ptr<std::promise<TSub>>& promise,
+      const std::string& key_sub);
+
+  /**
+   * Sends a request and waits for its response until the deadline.
+   *
+   * @return Whether the response arrived in time.
+   */
+  template <typename TSub, typename TPub, typename Deadline>
+  bool RequestUntil(const std::string& key_pub, const TPub& value_pub,
+                    const std::string& key_sub, const Deadline& deadline,
+                    std::future<TSub>& fut_value);
+
+  /**
+   * Dispatches a message from the persistent subscriber.
+   */
+  void OnMessage(const std::string& channel, const std::string& message);
+
+  std::string host_;
+  std::size_t port_;
+  std::string password_;
+
+  Codec codec_ = Codec::kMatlab;
+  std::unordered_map<std::string, Codec> key_codecs_;
+
+  Compression compression_ = Compression::kNone;
+  size_t compression_min_bytes_ = 0;
+  std::unordered_map<std::string, std::pair<Compression, size_t>>
+      key_compressions_;
+
+  mutable std::mutex mtx_pipeline_;
+  PipelinePolicy pipeline_policy_;
+  PipelineStats pipeline_stats_;
+  size_t num_pending_commands_ = 0;
+  size_t num_pending_bytes_ = 0;
+  Clock::time_point t_pending_;
+
+  // Commit time shared by the commands of the pending batch.
+  std::shared_ptr<std::atomic<Clock::rep>> t_commit_pending_;
+
+  std::atomic<bool> is_stats_enabled_ = false;
+  mutable std::mutex mtx_stats_;
+  RedisStats stats_;
+
+  std::atomic<bool> is_cache_enabled_ = false;
+  mutable std::mutex mtx_cache_;
+  std::vector<std::string> cache_patterns_;
+  std::unordered_map<std::string, std::any> cache_;
+  uint64_t cache_epoch_ = 1;
+  CacheStats cache_stats_;
+
+  struct SharedMemoryWriter {
+    std::string prefix;
+    size_t generation = 0;
+    std::unique_ptr<SharedMemorySegment> segment;
+
+    /// Previous generation, kept until the next one replaces it since Redis
+    /// may still hold handles to it.
+    std::unique_ptr<SharedMemorySegment> previous;
+  };
+
+  // Starts with a null byte so that it never matches an encoded value.
+  inline static const std::string kSharedMemoryPrefix{"\0shm ", 5};
+
+  std::atomic<bool> is_shared_memory_enabled_ = false;
+  std::mutex mtx_shared_memory_;
+  std::vector<std::pair<std::string, size_t>> shared_memory_patterns_;
+  std::unordered_map<std::string, SharedMemoryWriter> shared_memory_;
+
+  struct WriteBackEntry {
+    // Encoded value before shared-memory transfer.
+    std::string value;
+    std::vector<reply_callback_t> reply_callbacks;
+    bool is_pending = false;
+  };
+
+  // Entries are kept after flushing to reuse their buffers.
+  std::atomic<bool> is_write_back_enabled_ = false;
+  std::mutex mtx_write_back_;
+  std::vector<std::string> write_back_patterns_;
+  std::unordered_map<std::string, WriteBackEntry> write_back_;
+  size_t num_write_back_pending_ = 0;
+
+  std::mutex mtx_scripts_;
+  std::unordered_map<std::string, Script> scripts_;
+
+  // cpp_redis holds its own channel lock while it runs message callbacks, which
+  // lock mtx_channels_. Calls into the subscriber are therefore serialized by
+  // mtx_subscriber_ and never made while mtx_channels_ is held. When both are
+  // needed, mtx_subscriber_ is locked first.
+  std::mutex mtx_subscriber_;
+  std::mutex mtx_channels_;
+  uint64_t next_request_id_ = 0;
+  std::unordered_map<std::string, Channel> channels_;
+  std::unordered_map<std::string, Channel> patterns_;
+
+  // Destroyed after the subscriber so that no messages arrive while its
+  // threads are joined.
+  size_t num_subscriber_threads_ = 1;
+  Clock::duration late_response_timeout_ = std::chrono::seconds(1);
+  std::unique_ptr<ThreadPool<void>> subscriber_pool_;
+
+  // Declared last so that it disconnects before the channels are destroyed.
+  std::unique_ptr<cpp_redis::subscriber> subscriber_;
+};
 
 ////////////////////
-// Implementation //
-////////////////////
+// Implementation //
+////////////////////
+
+namespace redis_client_internal {
+
+inline size_t NumDigits(size_t n) {
+  size_t num_digits = 1;
+  for (; n >= 10; n /= 10) ++num_digits;
+  return num_digits;
+}
+
+}  // namespace redis_client_internal
+
+inline size_t RedisClient::CommandSize(
+    const std::vector<std::string>& command) {
+  using redis_client_internal::NumDigits;
+
+  // *<num_args>\r\n followed by $<len>\r\n<arg>\r\n for each argument.
+  size_t size = 3 + NumDigits(command.size());
+  for (const std::string& arg : command) {
+    size += 5 + NumDigits(arg.size()) + arg.size();
+  }
+  return size;
+}
+
+inline size_t RedisClient::ReplySize(const cpp_redis::reply& reply) {
+  using redis_client_internal::NumDigits;
+
+  if (reply.is_array()) {
+    size_t size = 3 + NumDigits(reply.as_array().size());
+    for (const cpp_redis::reply& row : reply.as_array()) size += ReplySize(row);
+    return size;
+  }
+  if (reply.is_bulk_string()) {
+    return 5 + NumDigits(reply.as_string().size()) + reply.as_string().size();
+  }
+  if (reply.is_simple_string()) return 3 + reply.as_string().size();
+  if (reply.is_error()) return 3 + reply.error().size();
+  if (reply.is_integer()) return 3 + std::to_string(reply.as_integer()).size();
+  return 5;  // $-1\r\n
+}
+
+inline RedisClient::reply_callback_t RedisClient::InstrumentCallback(
+    const std::vector<std::string>& command,
+    const reply_callback_t& reply_callback) {
+  std::shared_ptr<std::atomic<Clock::rep>> t_commit;
+  {
+    std::unique_lock<std::mutex> lock(mtx_pipeline_);
+    if (!t_commit_pending_) {
+      t_commit_pending_ = std::make_shared<std::atomic<Clock::rep>>(0);
+    }
+    t_commit = t_commit_pending_;
+  }
+  {
+    std::unique_lock<std::mutex> lock(mtx_stats_);
+    RedisCommandStats& stats = stats_.commands[command.front()];
+    ++stats.num_commands;
+    stats.num_bytes_out += CommandSize(command);
+    ++stats_.num_in_flight;
+    stats_.max_in_flight = std::max(stats_.max_in_flight, stats_.num_in_flight);
+  }
+
+  return [this, reply_callback, t_commit = std::move(t_commit),
+          t_send = Clock::now(),
+          name = command.front()](cpp_redis::reply& reply) {
+    const Clock::time_point t_reply = Clock::now();
+    const size_t num_bytes_in = ReplySize(reply);
+    const bool is_error = reply.is_error();
+    reply_callback(reply);
+    const Clock::time_point t_done = Clock::now();
+
+    // Commands committed directly through cpp_redis have no commit time.
+    const Clock::rep rep_commit = t_commit->load(std::memory_order_relaxed);
+    const Clock::time_point t_committed =
+        rep_commit == 0 ? t_send
+                        : Clock::time_point(Clock::duration(rep_commit));
+
+    std::unique_lock<std::mutex> lock(mtx_stats_);
+    RedisCommandStats& stats = stats_.commands[name];
+    if (is_error) ++stats.num_errors;
+    stats.num_bytes_in += num_bytes_in;
+    stats.queue_latency.Add(t_committed - t_send);
+    stats.reply_latency.Add(t_reply - t_committed);
+    stats.decode_latency.Add(t_done - t_reply);
+    if (stats_.num_in_flight > 0) --stats_.num_in_flight;
+  };
+}
+
+inline bool RedisClient::IsPipelineDue() const {
+  const PipelinePolicy& policy = pipeline_policy_;
+  if (num_pending_commands_ == 0) return false;
+  return (policy.max_commands > 0 &&
+          num_pending_commands_ >= policy.max_commands) ||
+         (policy.max_bytes > 0 && num_pending_bytes_ >= policy.max_bytes) ||
+         (policy.max_age.count() > 0 &&
+          Clock::now() - t_pending_ >= policy.max_age);
+}
+
+inline RedisClient& RedisClient::Send(const std::vector<std::string>& command,
+                                      const reply_callback_t& reply_callback) {
+  Queue(command, reply_callback);
+  if (CountPending(1, CommandSize(command))) commit();
+  return *this;
+}
+
+inline void RedisClient::Queue(const std::vector<std::string>& command,
+                               const reply_callback_t& reply_callback) {
+  FlushWriteBack();
+  QueueUnbuffered(command, reply_callback);
+}
+
+inline void RedisClient::QueueUnbuffered(
+    const std::vector<std::string>& command,
+    const reply_callback_t& reply_callback) {
+  if (is_stats_enabled_) {
+    cpp_redis::client::send(command,
+                            InstrumentCallback(command, reply_callback));
+  } else {
+    cpp_redis::client::send(command, reply_callback);
+  }
+}
+
+inline std::vector<std::string> RedisClient::KeysCommand(
+    const std::string& name, const std::vector<std::string>& keys) {
+  std::vector<std::string> command;
+  command.reserve(keys.size() + 1);
+  command.push_back(name);
+  command.insert(command.end(), keys.begin(), keys.end());
+  return command;
+}
+
+inline bool RedisClient::CountPending(size_t num_commands, size_t num_bytes) {
+  std::unique_lock<std::mutex> lock(mtx_pipeline_);
+  if (num_pending_commands_ == 0 && pipeline_policy_.max_age.count() > 0) {
+    t_pending_ = Clock::now();
+  }
+  num_pending_commands_ += num_commands;
+  num_pending_bytes_ += num_bytes;
+  return IsPipelineDue();
+}
+
+inline std::future<cpp_redis::reply> RedisClient::Send(
+    const std::vector<std::string>& command) {
+  auto promise = std::make_shared<std::promise<cpp_redis::reply>>();
+  Send(command,
+       [promise](cpp_redis::reply& reply) { promise->set_value(reply); });
+  return promise->get_future();
+}
+
+inline RedisClient& RedisClient::commit() {
+  FlushWriteBack();
+  {
+    std::unique_lock<std::mutex> lock(mtx_pipeline_);
+    if (num_pending_commands_ > 0) {
+      PipelineStats& stats = pipeline_stats_;
+      ++stats.num_flushes;
+      stats.num_commands += num_pending_commands_;
+      stats.num_bytes += num_pending_bytes_;
+      stats.max_batch_commands =
+          std::max(stats.max_batch_commands, num_pending_commands_);
+      stats.max_batch_bytes =
+          std::max(stats.max_batch_bytes, num_pending_bytes_);
+      num_pending_commands_ = 0;
+      num_pending_bytes_ = 0;
+    }
+    if (t_commit_pending_) {
+      t_commit_pending_->store(Clock::now().time_since_epoch().count(),
+                               std::memory_order_relaxed);
+      t_commit_pending_.reset();
+    }
+  }
+  cpp_redis::client::commit();
+  return *this;
+}
+
+inline RedisClient& RedisClient::sync_commit() {
+  commit();
+  cpp_redis::client::sync_commit();
+  return *this;
+}
+
+template <class Rep, class Period>
+RedisClient& RedisClient::sync_commit(
+    const std::chrono::duration<Rep, Period>& timeout) {
+  commit();
+  cpp_redis::client::sync_commit(timeout);
+  return *this;
+}
+
+inline RedisClient& RedisClient::commit_if_due() {
+  bool is_due;
+  {
+    std::unique_lock<std::mutex> lock(mtx_pipeline_);
+    is_due = IsPipelineDue();
+  }
+  if (is_due) commit();
+  return *this;
+}
+
+template <typename T>
+std::string RedisClient::Encode(const std::string& key, const T& value) const {
+  std::string str;
+  Encode(key, value, str);
+  return str;
+}
+
+template <typename T>
+void RedisClient::Encode(const std::string& key, const T& value,
+                         std::string& str) const {
+  if constexpr (is_eigen_dense<T>::value) {
+    if (codec(key) == Codec::kTensor) {
+      str = EncodeTensor(value);
+    } else {
+      // Reuse the capacity of str.
+      str.clear();
+      EncodeMatlab(value, str);
+    }
+    CompressValue(key, str);
+    return;
+  }
+  ToString(str, value);
+  CompressValue(key, str);
+}
+
+template <typename T>
+T RedisClient::Decode(const std::string& str) {
+  if (IsSharedMemoryHandle(str)) {
+    thread_local std::string buffer;
+    ReadSharedMemory(str, buffer);
+    return Decode<T>(buffer);
+  }
+  if (IsCompressedString(str)) {
+    thread_local std::string buffer;
+    Decompress(str, buffer);
+    return Decode<T>(buffer);
+  }
+  if constexpr (is_eigen_plain<T>::value) {
+    if (IsTensorString(str)) return DecodeTensor<T>(str);
+    return DecodeMatlab<T>(str);
+  }
+  return FromString<T>(str);
+}
+
+template <typename T>
+void RedisClient::Decode(const std::string& str, T& value) {
+  if (IsSharedMemoryHandle(str)) {
+    thread_local std::string buffer;
+    ReadSharedMemory(str, buffer);
+    Decode(buffer, value);
+    return;
+  }
+  if (IsCompressedString(str)) {
+    thread_local std::string buffer;
+    Decompress(str, buffer);
+    Decode(buffer, value);
+    return;
+  }
+  if constexpr (is_eigen_plain<T>::value) {
+    if (IsTensorString(str)) {
+      DecodeTensor(str, value);
+    } else {
+      DecodeMatlab(str, value);
+    }
+    return;
+  }
+  FromString(str, value);
+}
+
+template <typename T>
+RedisClient& RedisClient::get(
+    const std::string& key, const std::function<void(T&&)>& reply_callback,
+    const std::function<void(const std::string&)>& error_callback) {
+  // Serve values written by this client that have not been sent yet.
+  if (is_write_back_enabled_) {
+    T value;
+    bool is_pending;
+    try {
+      is_pending = GetWriteBack(key, value);
+    } catch (const std::exception& e) {
+      if (error_callback) {
+        error_callback("RedisClient::get(): Exception thrown on key: " + key +
+                       "\n\t" + e.what());
+      }
+      return *this;
+    }
+    if (is_pending) {
+      reply_callback(std::move(value));
+      return *this;
+    }
+  }
+
+  // Serve cached values without contacting the server.
+  uint64_t cache_epoch = 0;
+  if (is_cache_enabled_) {
+    T value;
+    if (GetCached(key, value, cache_epoch)) {
+      reply_callback(std::move(value));
+      return *this;
+    }
+  }
+
+  Send({"GET", key}, [this, key, reply_callback, error_callback,
+                      cache_epoch](cpp_redis::reply& reply) {
+    if (!reply.is_string()) {
+      if (error_callback) {
+        error_callback(
+            "RedisClient::get(): Failed to get string value from key: " + key +
+            ".");
+      }
+      return;
+    }
+    try {
+      T value = Decode<T>(reply.as_string());
+      if (cache_epoch != 0) SetCached(key, value, cache_epoch);
+      reply_callback(std::move(value));
+    } catch (const std::exception& e) {
+      if (error_callback) {
+        error_callback("RedisClient::get(): Exception thrown on key: " + key +
+                       "\n\t" + e.what());
+      }
+      return;
+    }
+  });
+  return *this;
+}
+
+template <typename T>
+std::future<T> RedisClient::get(const std::string& key) {
+  auto promise = std::make_shared<std::promise<T>>();
+  get<T>(
+      key, [promise](T&& value) { promise->set_value(std::move(value)); },
+      [promise](const std::string& error) {
+        promise->set_exception(
+            std::make_exception_ptr(std::runtime_error(error)));
+      });
+  return promise->get_future();
+}
+
+template <typename T>
+std::future<void> RedisClient::get(const std::string& key, T& value) {
+  auto promise = std::make_shared<std::promise<void>>();
+  get<std::string>(
+      key,
+      [promise, key, &value](std::string&& str_value) {
+        try {
+          Decode(str_value, value);
+          promise->set_value();
+        } catch (const std::exception& e) {
+          const std::string error =
+              "RedisClient::get(): Exception thrown on key: " + key + "\n\t" +
+              e.what();
+          promise->set_exception(
+              std::make_exception_ptr(std::runtime_error(error)));
+        }
+      },
+      [promise](const std::string& error) {
+        promise->set_exception(
+            std::make_exception_ptr(std::runtime_error(error)));
+      });
+  return promise->get_future();
+}
+
+template <typename T>
+T RedisClient::sync_get(const std::string& key) {
+  std::future<T> future = get<T>(key);
+  commit();
+  return future.get();
+};
+
+template <typename T, typename Timeout>
+T RedisClient::sync_get(const std::string& key, const Timeout& timeout) {
+  std::future<T> future = get<T>(key);
+  commit();
+  if (!WaitFor(future, timeout)) {
+    throw std::runtime_error(
+        "RedisClient::sync_get(): Timed out waiting for key: " + key + ".");
+  }
+  return future.get();
+}
+
+template <typename T, typename Timeout>
+bool RedisClient::sync_get(const std::string& key, T& value,
+                           const Timeout& timeout) {
+  std::future<T> future = get<T>(key);
+  commit();
+  return WaitFor(future, timeout) && TryGet(future, value);
+}
+
+template <typename T>
+RedisClient& RedisClient::set(const std::string& key, const T& value,
+                              const reply_callback_t& reply_callback) {
+  // Encode directly into the command to avoid copying the value.
+  std::vector<std::string> command = {"SET", key, std::string()};
+  Encode(key, value, command[2]);
+  InvalidateCache(key);
+  if (WriteBack(key, command[2], reply_callback)) return *this;
+  WriteSharedMemory(key, command[2]);
+  Send(command, reply_callback);
+  return *this;
+}
+
+template <typename T>
+std::future<cpp_redis::reply> RedisClient::set(const std::string& key,
+                                               const T& value) {
+  auto promise = std::make_shared<std::promise<cpp_redis::reply>>();
+  set(key, value, [promise](cpp_redis::reply& reply) {
+    if (reply) {
+      promise->set_value(reply);
+    } else {
+      promise->set_exception(
+          std::make_exception_ptr(std::runtime_error(reply.error())));
+    }
+  });
+  return promise->get_future();
+}
+
+template <typename T>
+cpp_redis::reply RedisClient::sync_set(const std::string& key, const T& value) {
+  std::future<cpp_redis::reply> future = set(key, value);
+  commit();
+  return future.get();
+};
+
+template <typename T>
+bool RedisClient::ReplyToString(const cpp_redis::reply& reply, T& value) {
+  if (reply.is_error()) throw std::runtime_error(reply.error());
+  if (!reply.is_string()) throw std::runtime_error("Missing value.");
+  Decode(reply.as_string(), value);
+  return true;
+}
+
+template <typename Tuple, size_t... Is>
+void RedisClient::RepliesToTuple(const std::vector<cpp_redis::reply>& replies,
+                                 Tuple& values, std::index_sequence<Is...>) {
+  std::initializer_list<bool>{
+      ReplyToString(replies[Is], std::get<Is>(values))...};
+}
+
+template <typename Key, typename Val, typename>
+bool RedisClient::KeyvalToString(
+    const std::pair<Key, Val>& key_val,
+    std::pair<std::string, std::string>& key_valstr) const {
+  key_valstr.first = key_val.first;
+  Encode(key_valstr.first, key_val.second, key_valstr.second);
+  return true;
+}
+
+template <typename Tuple, size_t... Is>
+void RedisClient::KeyvalsToString(
+    const Tuple& args,
+    std::vector<std::pair<std::string, std::string>>& key_valstr,
+    std::index_sequence<Is...>) const {
+  std::initializer_list<bool>{
+      KeyvalToString(std::get<Is>(args), key_valstr[Is])...};
+}
+
+template <class... Pairs, typename>
+std::future<cpp_redis::reply> RedisClient::mset(const Pairs&... key_vals) {
+  constexpr size_t num_pairs = sizeof...(Pairs);
+  std::vector<std::pair<std::string, std::string>> key_valstr(num_pairs);
+  KeyvalsToString(std::make_tuple(key_vals...), key_valstr,
+                  std::index_sequence_for<Pairs...>{});
+
+  std::vector<std::string> command;
+  command.reserve(2 * num_pairs + 1);
+  command.push_back("MSET");
+  for (std::pair<std::string, std::string>& key_val : key_valstr) {
+    WriteSharedMemory(key_val.first, key_val.second);
+    InvalidateCache(key_val.first);
+    command.push_back(std::move(key_val.first));
+    command.push_back(std::move(key_val.second));
+  }
+  return Send(command);
+}
+
+template <class... Pairs, typename>
+cpp_redis::reply RedisClient::sync_mset(const Pairs&... key_vals) {
+  std::future<cpp_redis::reply> future = mset(key_vals...);
+  commit();
+  return future.get();
+}
+
+template <class... Ts, class... Strings, typename>
+std::future<std::tuple<Ts...>> RedisClient::mget(const Strings&... keys) {
+  static_assert(sizeof...(Ts) == sizeof...(Strings),
+                "Number of keys must equal number of output types.");
+
+  auto promise = std::make_shared<std::promise<std::tuple<Ts...>>>();
+  // const std::array<std::string, sizeof...(Ts)> keys = {{ keys... }};
+  // mget<Ts...>(keys, [promise](Ts&&... values) {
+  //   promise->set_value(std::tuple<Ts...>{ values... });
+  // }, [promise](const std::string& error) {
+  //   promise->set_exception(std::make_exception_ptr(std::runtime_error(error)));
+  // });
+  std::vector<std::string> command = {"MGET", keys...};
+  Send(command, [this, command, promise](cpp_redis::reply& reply) {
+    if (!reply.is_array()) {
+      promise->set_exception(std::make_exception_ptr(
+          std::runtime_error(MgetError(command.begin() + 1, command.end()))));
+      return;
+    }
+    std::tuple<Ts...> values;
+    try {
+      RepliesToTuple(reply.as_array(), values,
+                     std::index_sequence_for<Ts...>{});
+    } catch (const std::exception& e) {
+      promise->set_exception(std::make_exception_ptr(
+          std::runtime_error(MgetError(command.begin() + 1, command.end()))));
+      return;
+    }
+    promise->set_value(std::move(values));
+  });
+  return promise->get_future();
+}
+
+template <typename T>
+RedisClient& RedisClient::mget(
+    const std::vector<std::string>& keys,
+    const std::function<void(std::vector<T>&&)>& reply_callback,
+    const std::function<void(const std::string&)>& error_callback) {
+  std::vector<std::string> command(keys.size() + 1);
+  command[0] = "MGET";
+  std::copy(keys.begin(), keys.end(), command.begin() + 1);
+  Send(command, [command, reply_callback,
+                 error_callback](cpp_redis::reply& reply) {
+    std::vector<T> values;
+    try {
+      if (!reply.is_array()) throw std::runtime_error("Invalid reply.");
+      values.reserve(reply.as_array().size());
+      for (const cpp_redis::reply& r : reply.as_array()) {
+        values.emplace_back();
+        ReplyToString(r, values.back());
+      }
+    } catch (const std::exception& e) {
+      if (error_callback) {
+        error_callback(MgetError(command.begin() + 1, command.end()));
+      }
+      return;
+    }
+    reply_callback(std::move(values));
+  });
+  return *this;
+}
+
+template <typename T>
+std::future<std::vector<T>> RedisClient::mget(
+    const std::vector<std::string>& keys) {
+  auto promise = std::make_shared<std::promise<std::vector<T>>>();
+  mget<T>(
+      keys,
+      [promise](std::vector<T>&& values) {
+        promise->set_value(std::move(values));
+      },
+      [promise](const std::string& error) {
+        promise->set_exception(
+            std::make_exception_ptr(std::runtime_error(error)));
+      });
+  return promise->get_future();
+}
+
+template <typename T>
+std::future<void> RedisClient::mget(const std::vector<std::string>& keys,
+                                    T* values) {
+  auto promise = std::make_shared<std::promise<void>>();
+
+  // The callback keeps the command for the error message, since the keys may
+  // be gone by the time the reply arrives.
+  auto command = std::make_shared<std::vector<std::string>>(keys.size() + 1);
+  (*command)[0] = "MGET";
+  std::copy(keys.begin(), keys.end(), command->begin() + 1);
+  Send(*command, [command, values, promise](cpp_redis::reply& reply) {
+    try {
+      if (!reply.is_array() ||
+          reply.as_array().size() != command->size() - 1) {
+        throw std::runtime_error("Invalid reply.");
+      }
+      const std::vector<cpp_redis::reply>& replies = reply.as_array();
+      for (size_t i = 0; i < replies.size(); i++) {
+        ReplyToString(replies[i], values[i]);
+      }
+    } catch (const std::exception& e) {
+      promise->set_exception(std::make_exception_ptr(std::runtime_error(
+          MgetError(command->begin() + 1, command->end()))));
+      return;
+    }
+    promise->set_value();
+  });
+  return promise->get_future();
+}
+
+template <typename T, typename Timeout>
+std::vector<T> RedisClient::sync_mget(const std::vector<std::string>& keys,
+                                      const Timeout& timeout) {
+  std::future<std::vector<T>> future = mget<T>(keys);
+  commit();
+  if (!WaitFor(future, timeout)) {
+    throw std::runtime_error(
+        "RedisClient::sync_mget(): Timed out waiting for keys.");
+  }
+  return future.get();
+}
+
+template <typename T, typename Timeout>
+bool RedisClient::sync_mget(const std::vector<std::string>& keys,
+                            std::vector<T>& values, const Timeout& timeout) {
+  std::future<std::vector<T>> future = mget<T>(keys);
+  commit();
+  return WaitFor(future, timeout) && TryGet(future, values);
+}
+
+template <typename Iterator>
+std::string RedisClient::MgetError(Iterator it_key, Iterator it_end) {
+  std::string error = "RedisClient::mget(): Failed to get values from keys:";
+  for (; it_key != it_end; ++it_key) error += " " + *it_key;
+  return error + ".";
+}
+
+template <class... Ts, class... Args, typename>
+std::tuple<Ts...> RedisClient::sync_mget(const Args&... args) {
+  std::future<std::tuple<Ts...>> future = mget<Ts...>(args...);
+  commit();
+  return future.get();
+}
+
+template <typename T>
+std::vector<T> RedisClient::sync_mget(const std::vector<std::string>& keys) {
+  std::future<std::vector<T>> future = mget<T>(keys);
+  commit();
+  return future.get();
+}
+
+// template<typename Func, typename Tuple, size_t... Is>
+// void Apply(const Func& func, Tuple&& values, std::index_sequence<Is...>) {
+//   func(std::move(std::get<Is>(values))...);
+// }
+
+// template<class... Ts>
+// RedisClient& RedisClient::mget(const std::array<std::string, sizeof...(Ts)>&
+// keys,
+//                                const std::function<void(std::tuple<Ts...>&&)>
+//                                reply_callback, const std::function<void(const
+//                                std::string&)>& error_callback) {
+
+//   std::vector<std::string> command = {"MGET", args...};
+//   send(command, [command, reply_callback, error_callback](cpp_redis::reply&
+//   reply) {
+//     if (!reply.is_array()) {
+//       std::stringstream ss_error("RedisClient::mget(): Failed to get values
+//       from keys:"); for (size_t i = 1; i < command.size(); i++) ss_error << "
+//       " << command[i]; ss_error << "."; error_callback(ss_error.str());
+//       return;
+//     }
+//     std::tuple<Ts...> values;
+//     try {
+//       RepliesToTuple(reply.as_array(), values,
+//       std::index_sequence_for<Ts...>{});
+//     } catch (const std::exception& e) {
+//       std::stringstream ss_error("RedisClient::mget(): Failed to get values
+//       from keys:"); for (size_t i = 1; i < command.size(); i++) ss_error << "
+//       " << command[i]; ss_error << "."; error_callback(ss_error.str());
+//       return;
+//     }
+//     // Apply(reply_callback, values, std::index_sequence_for<Ts...>{});
+//   });
+//   return *this;
+// }
+
+template <typename T>
+RedisClient& RedisClient::mset(
+    const std::vector<std::pair<std::string, T>>& key_vals,
+    const reply_callback_t& reply_callback) {
+  std::vector<std::string> command;
+  command.reserve(2 * key_vals.size() + 1);
+  command.push_back("MSET");
+  for (const std::pair<std::string, T>& key_val : key_vals) {
+    InvalidateCache(key_val.first);
+    command.push_back(key_val.first);
+    command.push_back(Encode(key_val.first, key_val.second));
+    WriteSharedMemory(key_val.first, command.back());
+  }
+  Send(command, reply_callback);
+  return *this;
+}
+
+template <typename T>
+std::future<cpp_redis::reply> RedisClient::mset(
+    const std::vector<std::pair<std::string, T>>& key_vals) {
+  auto promise = std::make_shared<std::promise<cpp_redis::reply>>();
+  mset(key_vals, [promise](cpp_redis::reply& reply) {
+    if (reply) {
+      promise->set_value(reply);
+    } else {
+      promise->set_exception(
+          std::make_exception_ptr(std::runtime_error(reply.error())));
+    }
+  });
+  return promise->get_future();
+}
+
+template <typename T>
+cpp_redis::reply RedisClient::sync_mset(
+    const std::vector<std::pair<std::string, T>>& key_vals) {
+  std::future<cpp_redis::reply> future = mset(key_vals);
+  commit();
+  return future.get();
+}
+
+template <typename T>
+RedisClient& RedisClient::publish(const std::string& key, const T& value,
+                                  const reply_callback_t& reply_callback) {
+  std::string str;
+  Encode(key, value, str);
+  WriteSharedMemory(key, str);
+  Send({"PUBLISH", key, str}, reply_callback);
+  return *this;
+}
+
+template <typename T>
+RedisClient& RedisClient::hset(const std::string& key, const std::string& field,
+                               const T& value,
+                               const reply_callback_t& reply_callback) {
+  std::string str;
+  Encode(key, value, str);
+  InvalidateCache(key);
+  Send({"HSET", key, field, str}, reply_callback);
+  return *this;
+}
+
+template <typename T>
+std::future<cpp_redis::reply> RedisClient::hset(const std::string& key,
+                                                const std::string& field,
+                                                const T& value) {
+  std::string str;
+  Encode(key, value, str);
+  InvalidateCache(key);
+  return Send({"HSET", key, field, str});
+}
+
+template <typename T>
+cpp_redis::reply RedisClient::sync_hset(const std::string& key,
+                                        const std::string& field,
+                                        const T& value) {
+  std::future<cpp_redis::reply> future = hset(key, field, value);
+  commit();
+  return future.get();
+};
+
+template <class... Pairs, typename>
+std::future<cpp_redis::reply> RedisClient::hmset(const std::string& key,
+                                                 const Pairs&... field_vals) {
+  std::vector<std::string> command;
+  command.reserve(2 + 2 * sizeof...(Pairs));
+  command.push_back("HMSET");
+  command.push_back(key);
+  (AppendField(key, field_vals, command), ...);
+  InvalidateCache(key);
+  return Send(command);
+}
+
+template <typename T>
+std::future<cpp_redis::reply> RedisClient::hmset(
+    const std::string& key,
+    const std::vector<std::pair<std::string, T>>& field_vals) {
+  std::vector<std::string> command;
+  command.reserve(2 + 2 * field_vals.size());
+  command.push_back("HMSET");
+  command.push_back(key);
+  for (const std::pair<std::string, T>& field_val : field_vals) {
+    AppendField(key, field_val, command);
+  }
+  InvalidateCache(key);
+  return Send(command);
+}
+
+template <class... Pairs, typename>
+cpp_redis::reply RedisClient::sync_hmset(const std::string& key,
+                                         const Pairs&... field_vals) {
+  std::future<cpp_redis::reply> future = hmset(key, field_vals...);
+  commit();
+  return future.get();
+}
+
+template <class... Ts, class... Strings, typename>
+std::future<std::tuple<Ts...>> RedisClient::hmget(const std::string& key,
+                                                  const Strings&... fields) {
+  static_assert(sizeof...(Ts) == sizeof...(Strings),
+                "Number of fields must equal number of output types.");
+
+  auto promise = std::make_shared<std::promise<std::tuple<Ts...>>>();
+  Send({"HMGET", key, fields...}, [key, promise](cpp_redis::reply& reply) {
+    std::tuple<Ts...> values;
+    try {
+      if (!reply.is_array() || reply.as_array().size() != sizeof...(Ts)) {
+        throw std::runtime_error("Invalid reply.");
+      }
+      RepliesToTuple(reply.as_array(), values,
+                     std::index_sequence_for<Ts...>{});
+    } catch (const std::exception& e) {
+      promise->set_exception(std::make_exception_ptr(std::runtime_error(
+          "RedisClient::hmget(): Failed to get fields from hash: " + key +
+          "\n\t" + e.what())));
+      return;
+    }
+    promise->set_value(std::move(values));
+  });
+  return promise->get_future();
+}
+
+template <class... Ts, class... Strings, typename>
+std::future<void> RedisClient::hmget(const std::string& key,
+                                     std::tuple<Ts&...> values,
+                                     const Strings&... fields) {
+  static_assert(sizeof...(Ts) == sizeof...(Strings),
+                "Number of fields must equal number of output values.");
+
+  auto promise = std::make_shared<std::promise<void>>();
+  Send({"HMGET", key, fields...},
+       [key, values, promise](cpp_redis::reply& reply) mutable {
+         try {
+           if (!reply.is_array() || reply.as_array().size() != sizeof...(Ts)) {
+             throw std::runtime_error("Invalid reply.");
+           }
+           RepliesToTuple(reply.as_array(), values,
+                          std::index_sequence_for<Ts...>{});
+         } catch (const std::exception& e) {
+           promise->set_exception(std::make_exception_ptr(std::runtime_error(
+               "RedisClient::hmget(): Failed to get fields from hash: " + key +
+               "\n\t" + e.what())));
+           return;
+         }
+         promise->set_value();
+       });
+  return promise->get_future();
+}
+
+template <class... Ts, class... Strings, typename>
+std::tuple<Ts...> RedisClient::sync_hmget(const std::string& key,
+                                          const Strings&... fields) {
+  std::future<std::tuple<Ts...>> future = hmget<Ts...>(key, fields...);
+  commit();
+  return future.get();
+}
+
+template <class... Ts, class... Strings, typename>
+void RedisClient::sync_hmget(const std::string& key, std::tuple<Ts&...> values,
+                             const Strings&... fields) {
+  std::future<void> future = hmget(key, values, fields...);
+  commit();
+  future.get();
+}
+
+template <typename T>
+std::future<std::unordered_map<std::string, T>> RedisClient::hgetall(
+    const std::string& key) {
+  auto promise =
+      std::make_shared<std::promise<std::unordered_map<std::string, T>>>();
+  Send({"HGETALL", key}, [key, promise](cpp_redis::reply& reply) {
+    std::unordered_map<std::string, T> values;
+    try {
+      if (!reply.is_array() || reply.as_array().size() % 2 != 0) {
+        throw std::runtime_error("Invalid reply.");
+      }
+      const std::vector<cpp_redis::reply>& field_vals = reply.as_array();
+      values.reserve(field_vals.size() / 2);
+      for (size_t i = 0; i < field_vals.size(); i += 2) {
+        if (field_vals[i].is_error() || !field_vals[i].is_string()) {
+          throw std::runtime_error("Invalid field.");
+        }
+        ReplyToString(field_vals[i + 1], values[field_vals[i].as_string()]);
+      }
+    } catch (const std::exception& e) {
+      promise->set_exception(std::make_exception_ptr(std::runtime_error(
+          "RedisClient::hgetall(): Failed to get fields from hash: " + key +
+          "\n\t" + e.what())));
+      return;
+    }
+    promise->set_value(std::move(values));
+  });
+  return promise->get_future();
+}
+
+template <typename T>
+std::unordered_map<std::string, T> RedisClient::sync_hgetall(
+    const std::string& key) {
+  std::future<std::unordered_map<std::string, T>> future = hgetall<T>(key);
+  commit();
+  return future.get();
+}
+
+template <typename T>
+std::future<cpp_redis::reply> RedisClient::publish(const std::string& key,
+                                                   const T& value) {
+  std::string str;
+  Encode(key, value, str);
+  WriteSharedMemory(key, str);
+  return Send({"PUBLISH", key, str});
+}
+
+template <typename T>
+cpp_redis::reply RedisClient::sync_publish(const std::string& key,
+                                           const T& value) {
+  std::future<cpp_redis::reply> future = publish(key, value);
+  commit();
+  return future.get();
+};
+
+template <class... Pairs, typename>
+std::future<size_t> RedisClient::publish_many(const Pairs&... channel_vals) {
+  auto batch = std::make_shared<PublishBatch>(sizeof...(Pairs));
+  std::future<size_t> future = batch->get_future();
+
+  // Share one callback and one command buffer across the batch.
+  const reply_callback_t reply_callback =
+      [batch](cpp_redis::reply& reply) { batch->OnReply(reply); };
+  std::vector<std::string> command = {"PUBLISH", "", ""};
+  size_t num_bytes = 0;
+  (QueuePublish(channel_vals.first, channel_vals.second, reply_callback,
+                command, num_bytes),
+   ...);
+  FinishPublishBatch(sizeof...(Pairs), num_bytes, *batch);
+  return future;
+}
+
+template <typename T>
+std::future<size_t> RedisClient::publish_many(
+    const std::vector<std::pair<std::string, T>>& channel_vals) {
+  auto batch = std::make_shared<PublishBatch>(channel_vals.size());
+  std::future<size_t> future = batch->get_future();
+
+  const reply_callback_t reply_callback =
+      [batch](cpp_redis::reply& reply) { batch->OnReply(reply); };
+  std::vector<std::string> command = {"PUBLISH", "", ""};
+  size_t num_bytes = 0;
+  for (const std::pair<std::string, T>& channel_val : channel_vals) {
+    QueuePublish(channel_val.first, channel_val.second, reply_callback,
+                 command, num_bytes);
+  }
+  FinishPublishBatch(channel_vals.size(), num_bytes, *batch);
+  return future;
+}
+
+template <class... Pairs, typename>
+size_t RedisClient::sync_publish_many(const Pairs&... channel_vals) {
+  std::future<size_t> future = publish_many(channel_vals...);
+  commit();
+  return future.get();
+}
 
 template <typename T>
-RedisClient& RedisClient::get(
-    const std::string& key, const std::function<void(T&&)>& reply_callback,
-    const std::function<void(const std::string&)>& error_callback) {
-  send({"GET", key}, [key, reply_callback,
-                      error_callback](cpp_redis::reply& reply) {
-    if (!reply.is_string()) {
-      if (error_callback) {
-        error_callback(
-            "RedisClient::get(): Failed to get string value from key: " + key +
-            ".");
-      }
+size_t RedisClient::sync_publish_many(
+    const std::vector<std::pair<std::string, T>>& channel_vals) {
+  std::future<size_t> future = publish_many(channel_vals);
+  commit();
+  return future.get();
+}
+
+template <typename T>
+void RedisClient::QueuePublish(const std::string& channel, const T& value,
+                               const reply_callback_t& reply_callback,
+                               std::vector<std::string>& command,
+                               size_t& num_bytes) {
+  command[1] = channel;
+  Encode(channel, value, command[2]);
+  WriteSharedMemory(channel, command[2]);
+  Queue(command, reply_callback);
+  num_bytes += CommandSize(command);
+}
+
+inline void RedisClient::FinishPublishBatch(size_t num_commands,
+                                            size_t num_bytes,
+                                            PublishBatch& batch) {
+  if (num_commands == 0) {
+    batch.Complete();
+    return;
+  }
+  if (CountPending(num_commands, num_bytes)) commit();
+}
+
+inline void RedisClient::PublishBatch::OnReply(const cpp_redis::reply& reply) {
+  if (reply.is_integer()) {
+    num_receivers_ += reply.as_integer();
+  } else if (error_.empty()) {
+    error_ = reply.is_error() ? reply.error() : "Unexpected reply.";
+  }
+  if (--num_remaining_ == 0) Complete();
+}
+
+inline void RedisClient::PublishBatch::Complete() {
+  if (error_.empty()) {
+    promise_.set_value(num_receivers_);
+  } else {
+    promise_.set_exception(std::make_exception_ptr(std::runtime_error(
+        "RedisClient::publish_many(): " + error_)));
+  }
+}
+
+template <typename Field, typename T>
+void RedisClient::AppendField(const std::string& key,
+                              const std::pair<Field, T>& field_val,
+                              std::vector<std::string>& command) const {
+  command.push_back(field_val.first);
+  command.emplace_back();
+  Encode(key, field_val.second, command.back());
+}
+
+inline std::future<std::string> RedisClient::SendXadd(
+    const std::vector<std::string>& command) {
+  auto promise = std::make_shared<std::promise<std::string>>();
+  Send(command, [promise, key = command[1]](cpp_redis::reply& reply) {
+    if (reply.is_error() || !reply.is_string()) {
+      promise->set_exception(std::make_exception_ptr(std::runtime_error(
+          "RedisClient::xadd(): Failed to add entry to stream: " + key +
+          (reply.is_error() ? " (" + reply.error() + ")." : "."))));
       return;
     }
+    promise->set_value(reply.as_string());
+  });
+  return promise->get_future();
+}
+
+template <class... Pairs, typename>
+std::future<std::string> RedisClient::xadd(const std::string& key,
+                                           const Pairs&... field_vals) {
+  std::vector<std::string> command;
+  command.reserve(3 + 2 * sizeof...(Pairs));
+  command.push_back("XADD");
+  command.push_back(key);
+  command.push_back("*");
+  (AppendField(key, field_vals, command), ...);
+  return SendXadd(command);
+}
+
+template <typename T>
+std::future<std::string> RedisClient::xadd(
+    const std::string& key,
+    const std::vector<std::pair<std::string, T>>& field_vals, size_t max_len) {
+  std::vector<std::string> command;
+  command.reserve(6 + 2 * field_vals.size());
+  command.push_back("XADD");
+  command.push_back(key);
+  if (max_len > 0) {
+    command.push_back("MAXLEN");
+    command.push_back("~");
+    command.push_back(std::to_string(max_len));
+  }
+  command.push_back("*");
+  for (const std::pair<std::string, T>& field_val : field_vals) {
+    AppendField(key, field_val, command);
+  }
+  return SendXadd(command);
+}
+
+template <class... Pairs, typename>
+std::string RedisClient::sync_xadd(const std::string& key,
+                                   const Pairs&... field_vals) {
+  std::future<std::string> future = xadd(key, field_vals...);
+  commit();
+  return future.get();
+}
+
+template <typename T>
+std::vector<RedisClient::StreamEntry<T>> RedisClient::DecodeStreamEntries(
+    const std::vector<cpp_redis::reply>& replies) {
+  std::vector<StreamEntry<T>> entries(replies.size());
+  for (size_t i = 0; i < replies.size(); i++) {
+    const cpp_redis::reply& reply = replies[i];
+    if (!reply.is_array() || reply.as_array().size() != 2 ||
+        !reply.as_array()[0].is_string() || !reply.as_array()[1].is_array()) {
+      throw std::runtime_error("Invalid stream entry.");
+    }
+    const std::vector<cpp_redis::reply>& field_vals =
+        reply.as_array()[1].as_array();
+    if (field_vals.size() % 2 != 0) {
+      throw std::runtime_error("Invalid stream entry fields.");
+    }
+
+    StreamEntry<T>& entry = entries[i];
+    entry.id = reply.as_array()[0].as_string();
+    entry.fields.resize(field_vals.size() / 2);
+    for (size_t j = 0; j < entry.fields.size(); j++) {
+      entry.fields[j].first = field_vals[2 * j].as_string();
+      Decode(field_vals[2 * j + 1].as_string(), entry.fields[j].second);
+    }
+  }
+  return entries;
+}
+
+template <typename T>
+std::future<std::vector<RedisClient::StreamEntry<T>>>
+RedisClient::SendStreamRead(const std::vector<std::string>& command,
+                            bool is_xread) {
+  auto promise = std::make_shared<std::promise<std::vector<StreamEntry<T>>>>();
+  const std::string& key = is_xread ? command[command.size() - 2] : command[1];
+  Send(command, [promise, key, is_xread](cpp_redis::reply& reply) {
     try {
-      reply_callback(FromString<T>(reply.as_string()));
-    } catch (const std::exception& e) {
-      if (error_callback) {
-        error_callback("RedisClient::get(): Exception thrown on key: " + key +
-                       "\n\t" + e.what());
+      if (is_xread && reply.is_null()) {
+        // Timed out without new entries.
+        promise->set_value({});
+        return;
       }
-      return;
+      if (!reply.is_array()) throw std::runtime_error("Invalid reply.");
+      if (!is_xread) {
+        promise->set_value(DecodeStreamEntries<T>(reply.as_array()));
+        return;
+      }
+
+      // XREAD replies with [[key, entries]] for the single requested key.
+      const std::vector<cpp_redis::reply>& streams = reply.as_array();
+      if (streams.size() != 1 || !streams[0].is_array() ||
+          streams[0].as_array().size() != 2 ||
+          !streams[0].as_array()[1].is_array()) {
+        throw std::runtime_error("Invalid reply.");
+      }
+      promise->set_value(
+          DecodeStreamEntries<T>(streams[0].as_array()[1].as_array()));
+    } catch (const std::exception& e) {
+      promise->set_exception(std::make_exception_ptr(std::runtime_error(
+          "RedisClient::" + std::string(is_xread ? "xread" : "xrange") +
+          "(): Failed to read entries from stream: " + key + " (" + e.what() +
+          ").")));
     }
   });
-  return *this;
+  return promise->get_future();
 }
 
 template <typename T>
-std::future<T> RedisClient::get(const std::string& key) {
-  auto promise = std::make_shared<std::promise<T>>();
-  get<T>(
-      key, [promise](T&& value) { promise->set_value(std::move(value)); },
-      [promise](const std::string& error) {
-        promise->set_exception(
-            std::make_exception_ptr(std::runtime_error(error)));
-      });
-  return promise->get_future();
+std::future<std::vector<RedisClient::StreamEntry<T>>> RedisClient::xrange(
+    const std::string& key, const std::string& start, const std::string& end,
+    size_t count) {
+  std::vector<std::string> command = {"XRANGE", key, start, end};
+  if (count > 0) {
+    command.push_back("COUNT");
+    command.push_back(std::to_string(count));
+  }
+  return SendStreamRead<T>(command, false);
 }
 
 template <typename T>
-std::future<void> RedisClient::get(const std::string& key, T& value) {
-  auto promise = std::make_shared<std::promise<void>>();
-  get<std::string>(
-      key,
-      [promise, key, &value](std::string&& str_value) {
-        try {
-          FromString(str_value, value);
-          promise->set_value();
-        } catch (const std::exception& e) {
-          const std::string error =
-              "RedisClient::get(): Exception thrown on key: " + key + "\n\t" +
-              e.what();
-          promise->set_exception(
-              std::make_exception_ptr(std::runtime_error(error)));
-        }
-      },
-      [promise](const std::string& error) {
-        promise->set_exception(
-            std::make_exception_ptr(std::runtime_error(error)));
-      });
-  return promise->get_future();
+std::future<std::vector<RedisClient::StreamEntry<T>>> RedisClient::xrevrange(
+    const std::string& key, const std::string& end, const std::string& start,
+    size_t count) {
+  std::vector<std::string> command = {"XREVRANGE", key, end, start};
+  if (count > 0) {
+    command.push_back("COUNT");
+    command.push_back(std::to_string(count));
+  }
+  return SendStreamRead<T>(command, false);
 }
 
 template <typename T>
-T RedisClient::sync_get(const std::string& key) {
-  std::future<T> future = get<T>(key);
+std::vector<RedisClient::StreamEntry<T>> RedisClient::sync_xrange(
+    const std::string& key, const std::string& start, const std::string& end,
+    size_t count) {
+  std::future<std::vector<StreamEntry<T>>> future =
+      xrange<T>(key, start, end, count);
   commit();
   return future.get();
-};
+}
 
 template <typename T>
-RedisClient& RedisClient::set(const std::string& key, const T& value,
-                              const reply_callback_t& reply_callback) {
-  send({"SET", key, ToString(value)}, reply_callback);
-  return *this;
+std::future<std::vector<RedisClient::StreamEntry<T>>> RedisClient::xread(
+    const std::string& key, const std::string& id, size_t count,
+    std::chrono::milliseconds block) {
+  std::vector<std::string> command = {"XREAD"};
+  if (count > 0) {
+    command.push_back("COUNT");
+    command.push_back(std::to_string(count));
+  }
+  if (block > std::chrono::milliseconds::zero()) {
+    // BLOCK 0 waits indefinitely.
+    const bool is_indefinite = block == std::chrono::milliseconds::max();
+    command.push_back("BLOCK");
+    command.push_back(is_indefinite ? "0" : std::to_string(block.count()));
+  }
+  command.push_back("STREAMS");
+  command.push_back(key);
+  command.push_back(id);
+  return SendStreamRead<T>(command, true);
 }
 
 template <typename T>
-std::future<cpp_redis::reply> RedisClient::set(const std::string& key,
-                                               const T& value) {
-  auto promise = std::make_shared<std::promise<cpp_redis::reply>>();
-  set(key, value, [promise](cpp_redis::reply& reply) {
-    if (reply) {
-      promise->set_value(reply);
-    } else {
-      promise->set_exception(
-          std::make_exception_ptr(std::runtime_error(reply.error())));
+std::vector<RedisClient::StreamEntry<T>> RedisClient::sync_xread(
+    const std::string& key, const std::string& id, size_t count,
+    std::chrono::milliseconds block) {
+  std::future<std::vector<StreamEntry<T>>> future =
+      xread<T>(key, id, count, block);
+  commit();
+  return future.get();
+}
+
+inline std::string RedisClient::register_script(const std::string& name,
+                                               const std::string& source) {
+  std::future<cpp_redis::reply> fut_sha = Send({"SCRIPT", "LOAD", source});
+  commit();
+  const cpp_redis::reply reply = fut_sha.get();
+  if (!reply.is_string() || reply.is_error()) {
+    throw std::runtime_error(
+        "RedisClient::register_script(): Failed to load script: " + name +
+        (reply.is_error() ? " (" + reply.as_string() + ")." : "."));
+  }
+
+  std::unique_lock<std::mutex> lock(mtx_scripts_);
+  scripts_[name] = {source, reply.as_string()};
+  return reply.as_string();
+}
+
+template <typename T>
+T RedisClient::DecodeScriptResult(const cpp_redis::reply& reply) {
+  if constexpr (std::is_same_v<T, cpp_redis::reply>) {
+    return reply;
+  } else {
+    if (reply.is_string() && !reply.is_error()) {
+      return Decode<T>(reply.as_string());
+    }
+    if (reply.is_integer()) {
+      if constexpr (std::is_arithmetic_v<T>) {
+        return static_cast<T>(reply.as_integer());
+      } else {
+        return Decode<T>(std::to_string(reply.as_integer()));
+      }
+    }
+    throw std::runtime_error("Invalid reply.");
+  }
+}
+
+template <typename TResult, class... Args>
+std::future<TResult> RedisClient::evalsha(const std::string& name,
+                                          const std::vector<std::string>& keys,
+                                          const Args&... args) {
+  Script script;
+  {
+    std::unique_lock<std::mutex> lock(mtx_scripts_);
+    const auto it = scripts_.find(name);
+    if (it == scripts_.end()) {
+      throw std::invalid_argument(
+          "RedisClient::evalsha(): Unregistered script: " + name + ".");
+    }
+    script = it->second;
+  }
+
+  // EVALSHA sha numkeys key [key ...] arg [arg ...]
+  std::vector<std::string> command;
+  command.reserve(3 + keys.size() + sizeof...(Args));
+  command.push_back("EVALSHA");
+  command.push_back(std::move(script.sha));
+  command.push_back(std::to_string(keys.size()));
+  command.insert(command.end(), keys.begin(), keys.end());
+  (command.push_back(Encode(std::string(), args)), ...);
+
+  auto promise = std::make_shared<std::promise<TResult>>();
+  auto Resolve = [name, promise](const cpp_redis::reply& reply) {
+    try {
+      if (reply.is_error()) throw std::runtime_error(reply.as_string());
+      promise->set_value(DecodeScriptResult<TResult>(reply));
+    } catch (const std::exception& e) {
+      promise->set_exception(std::make_exception_ptr(std::runtime_error(
+          "RedisClient::evalsha(): Failed to run script: " + name + " (" +
+          e.what() + ").")));
+    }
+  };
+  Send(command, [this, command, source = std::move(script.source),
+                 Resolve](cpp_redis::reply& reply) mutable {
+    if (!reply.is_error() || reply.as_string().rfind("NOSCRIPT", 0) != 0) {
+      Resolve(reply);
+      return;
     }
+
+    // The server's script cache was flushed. EVAL runs the script and loads
+    // it under the same SHA1.
+    command[0] = "EVAL";
+    command[1] = std::move(source);
+    Send(command, [Resolve](cpp_redis::reply& reply) { Resolve(reply); });
+    commit();
   });
   return promise->get_future();
 }
 
-template <typename T>
-cpp_redis::reply RedisClient::sync_set(const std::string& key, const T& value) {
-  std::future<cpp_redis::reply> future = set(key, value);
+template <typename TResult, class... Args>
+TResult RedisClient::sync_evalsha(const std::string& name,
+                                  const std::vector<std::string>& keys,
+                                  const Args&... args) {
+  std::future<TResult> future = evalsha<TResult>(name, keys, args...);
   commit();
   return future.get();
-};
+}
+
+inline RedisClient::~RedisClient() {
+  // Reply callbacks capture this, and cpp_redis::client only disconnects
+  // after the members are destroyed. Send the pending commands and wait for
+  // their callbacks, then disconnect while the members are still alive.
+  if (is_connected()) {
+    try {
+      sync_commit();
+    } catch (const std::exception&) {
+      // The connection is lost, and disconnect() clears the callbacks.
+    }
+  }
+  disconnect(true);
+
+  // Disconnect the subscriber before the channels are destroyed, and keep
+  // queued UnsubscribeChannel() jobs from using it while it disconnects.
+  std::unique_ptr<cpp_redis::subscriber> subscriber;
+  {
+    std::unique_lock<std::mutex> lock(mtx_subscriber_);
+    subscriber = std::move(subscriber_);
+  }
+}
+
+inline cpp_redis::subscriber& RedisClient::ConnectSubscriber() {
+  if (!subscriber_) {
+    subscriber_ = std::make_unique<cpp_redis::subscriber>();
+    subscriber_->connect(host_, port_);
+    if (!password_.empty()) subscriber_->auth(password_);
+  }
+  return *subscriber_;
+}
+
+inline void RedisClient::enable_cache(const std::string& pattern, int db) {
+  // Make sure the server publishes keyspace notifications.
+  std::future<cpp_redis::reply> fut_config =
+      Send({"CONFIG", "GET", "notify-keyspace-events"});
+  commit();
+  const cpp_redis::reply reply = fut_config.get();
+  if (reply.is_array() && reply.as_array().size() == 2 &&
+      reply.as_array()[1].is_string()) {
+    const std::string& flags = reply.as_array()[1].as_string();
+    auto HasFlag = [&flags](char flag) {
+      return flags.find(flag) != std::string::npos;
+    };
+    if (!HasFlag('K') || !(HasFlag('A') || (HasFlag('g') && HasFlag('$')))) {
+      throw std::runtime_error(
+          "RedisClient::enable_cache(): Keyspace notifications are disabled. "
+          "Enable them with: CONFIG SET notify-keyspace-events KA");
+    }
+  }
+
+  // Subscribe to keyspace notifications for the pattern.
+  const std::string prefix = "__keyspace@" + std::to_string(db) + "__:";
+  auto promise = std::make_shared<std::promise<void>>();
+  std::future<void> subscribed = promise->get_future();
+  {
+    std::unique_lock<std::mutex> lock(mtx_subscriber_);
+    cpp_redis::subscriber& subscriber = ConnectSubscriber();
+    subscriber.psubscribe(
+        prefix + pattern,
+        [this, idx_key = prefix.size()](const std::string& channel,
+                                        const std::string& /* event */) {
+          // Every event type invalidates, since any of them (set, del,
+          // expired, rename_from, ...) may change the value. Notifications
+          // don't identify the writer, so this client's own writes, including
+          // flushed write-back values and shared memory handles, invalidate
+          // the key once more when their notification arrives.
+          InvalidateCache(channel.substr(idx_key));
+        },
+        [promise](int64_t) mutable {
+          if (!promise) return;
+          promise->set_value();
+          promise.reset();
+        });
+    subscriber.commit();
+  }
+  subscribed.wait();
+
+  std::unique_lock<std::mutex> lock(mtx_cache_);
+  cache_patterns_.push_back(pattern);
+  is_cache_enabled_ = true;
+}
 
 template <typename T>
-bool RedisClient::ReplyToString(const cpp_redis::reply& reply, T& value) {
-  FromString(reply.as_string(), value);
-  return true;
+bool RedisClient::GetCached(const std::string& key, T& value,
+                            uint64_t& cache_epoch) {
+  std::unique_lock<std::mutex> lock(mtx_cache_);
+  const bool is_cacheable =
+      std::any_of(cache_patterns_.begin(), cache_patterns_.end(),
+                  [&key](const std::string& pattern) {
+                    return MatchGlob(pattern, key);
+                  });
+  if (!is_cacheable) return false;
+
+  const auto it = cache_.find(key);
+  if (it != cache_.end()) {
+    const T* cached_value = std::any_cast<T>(&it->second);
+    if (cached_value != nullptr) {
+      value = *cached_value;
+      ++cache_stats_.num_hits;
+      return true;
+    }
+  }
+
+  ++cache_stats_.num_misses;
+  cache_epoch = cache_epoch_;
+  return false;
 }
 
-template <typename Tuple, size_t... Is>
-void RedisClient::RepliesToTuple(const std::vector<cpp_redis::reply>& replies,
-                                 Tuple& values, std::index_sequence<Is...>) {
-  std::initializer_list<bool>{
-      ReplyToString(replies[Is], std::get<Is>(values))...};
+template <typename T>
+void RedisClient::SetCached(const std::string& key, const T& value,
+                            uint64_t cache_epoch) {
+  std::unique_lock<std::mutex> lock(mtx_cache_);
+  if (cache_epoch != cache_epoch_) return;
+  cache_[key] = value;
 }
 
-template <typename Key, typename Val, typename>
-bool RedisClient::KeyvalToString(
-    const std::pair<Key, Val>& key_val,
-    std::pair<std::string, std::string>& key_valstr) {
-  key_valstr.first = key_val.first;
-  ToString(key_valstr.second, key_val.second);
+inline void RedisClient::InvalidateCache(const std::string& key) {
+  if (!is_cache_enabled_) return;
+
+  std::unique_lock<std::mutex> lock(mtx_cache_);
+  const bool is_cacheable =
+      std::any_of(cache_patterns_.begin(), cache_patterns_.end(),
+                  [&key](const std::string& pattern) {
+                    return MatchGlob(pattern, key);
+                  });
+  if (!is_cacheable) return;
+
+  // Prevent in-flight GETs from caching stale values.
+  ++cache_epoch_;
+  if (cache_.erase(key) > 0) ++cache_stats_.num_invalidations;
+}
+
+inline bool RedisClient::WriteBack(const std::string& key, std::string& str,
+                                   const reply_callback_t& reply_callback) {
+  if (!is_write_back_enabled_) return false;
+
+  std::unique_lock<std::mutex> lock(mtx_write_back_);
+  auto it = write_back_.find(key);
+  if (it == write_back_.end()) {
+    const bool is_buffered =
+        std::any_of(write_back_patterns_.begin(), write_back_patterns_.end(),
+                    [&key](const std::string& pattern) {
+                      return MatchGlob(pattern, key);
+                    });
+    if (!is_buffered) return false;
+    it = write_back_.emplace(key, WriteBackEntry()).first;
+  }
+
+  WriteBackEntry& entry = it->second;
+  entry.value.swap(str);
+  if (reply_callback) entry.reply_callbacks.push_back(reply_callback);
+
+  // Count new keys toward the pipeline batch by the arguments they add to
+  // the MSET, and overwritten keys by how much their value grew. The old
+  // value is now in str.
+  using redis_client_internal::NumDigits;
+  const size_t size_value =
+      NumDigits(entry.value.size()) + entry.value.size();
+  size_t num_commands = 0;
+  size_t num_bytes = 0;
+  if (!entry.is_pending) {
+    entry.is_pending = true;
+    ++num_write_back_pending_;
+    num_commands = 1;
+    num_bytes = 10 + NumDigits(key.size()) + key.size() + size_value;
+  } else {
+    const size_t size_old = NumDigits(str.size()) + str.size();
+    if (size_value > size_old) num_bytes = size_value - size_old;
+  }
+  lock.unlock();
+
+  if (CountPending(num_commands, num_bytes)) commit();
   return true;
 }
 
-template <typename Tuple, size_t... Is>
-void RedisClient::KeyvalsToString(
-    const Tuple& args,
-    std::vector<std::pair<std::string, std::string>>& key_valstr,
-    std::index_sequence<Is...>) {
-  std::initializer_list<bool>{
-      KeyvalToString(std::get<Is>(args), key_valstr[Is])...};
+template <typename T>
+bool RedisClient::GetWriteBack(const std::string& key, T& value) {
+  std::unique_lock<std::mutex> lock(mtx_write_back_);
+  const auto it = write_back_.find(key);
+  if (it == write_back_.end() || !it->second.is_pending) return false;
+  Decode(it->second.value, value);
+  return true;
 }
 
-template <class... Pairs, typename>
-std::future<cpp_redis::reply> RedisClient::mset(const Pairs&... key_vals) {
-  constexpr size_t num_pairs = sizeof...(Pairs);
-  std::vector<std::pair<std::string, std::string>> key_valstr(num_pairs);
-  KeyvalsToString(std::make_tuple(key_vals...), key_valstr,
-                  std::index_sequence_for<Pairs...>{});
-  return cpp_redis::client::mset(key_valstr);
+inline void RedisClient::FlushWriteBack() {
+  if (!is_write_back_enabled_) return;
+
+  std::vector<std::string> command;
+  std::vector<reply_callback_t> reply_callbacks;
+  {
+    std::unique_lock<std::mutex> lock(mtx_write_back_);
+    if (num_write_back_pending_ == 0) return;
+
+    command.reserve(2 * num_write_back_pending_ + 1);
+    command.push_back("MSET");
+    for (auto& key_entry : write_back_) {
+      WriteBackEntry& entry = key_entry.second;
+      if (!entry.is_pending) continue;
+      entry.is_pending = false;
+
+      command.push_back(key_entry.first);
+      command.push_back(std::move(entry.value));
+      WriteSharedMemory(key_entry.first, command.back());
+      for (reply_callback_t& reply_callback : entry.reply_callbacks) {
+        reply_callbacks.push_back(std::move(reply_callback));
+      }
+      entry.reply_callbacks.clear();
+    }
+    num_write_back_pending_ = 0;
+
+    // Queue while locked so that concurrent flushes keep their order. The
+    // buffered keys have already been counted toward the pipeline batch.
+    QueueUnbuffered(command, [reply_callbacks = std::move(reply_callbacks)](
+                                 cpp_redis::reply& reply) {
+      for (const reply_callback_t& reply_callback : reply_callbacks) {
+        reply_callback(reply);
+      }
+    });
+  }
 }
 
-template <class... Pairs, typename>
-cpp_redis::reply RedisClient::sync_mset(const Pairs&... key_vals) {
-  std::future<cpp_redis::reply> future = mset(key_vals...);
-  commit();
-  return future.get();
+inline void RedisClient::CompressValue(const std::string& key,
+                                       std::string& str) const {
+  Compression compression = compression_;
+  size_t min_bytes = compression_min_bytes_;
+  if (!key_compressions_.empty()) {
+    const auto it = key_compressions_.find(key);
+    if (it != key_compressions_.end()) {
+      std::tie(compression, min_bytes) = it->second;
+    }
+  }
+  if (compression == Compression::kNone || str.size() < min_bytes ||
+      key.empty()) {
+    return;
+  }
+
+  std::string compressed;
+  if (Compress(str, compression, compressed)) str.swap(compressed);
+}
+
+inline void RedisClient::WriteSharedMemory(const std::string& key,
+                                           std::string& str) {
+  if (!is_shared_memory_enabled_) return;
+
+  std::unique_lock<std::mutex> lock(mtx_shared_memory_);
+  const auto it_pattern = std::find_if(
+      shared_memory_patterns_.begin(), shared_memory_patterns_.end(),
+      [&key](const std::pair<std::string, size_t>& pattern) {
+        return MatchGlob(pattern.first, key);
+      });
+  if (it_pattern == shared_memory_patterns_.end() ||
+      str.size() < it_pattern->second) {
+    return;
+  }
+
+  SharedMemoryWriter& writer = shared_memory_[key];
+  if (writer.prefix.empty()) {
+    static std::atomic<size_t> num_writers = 0;
+    writer.prefix = "/ctrl_utils." + std::to_string(getpid()) + "." +
+                    std::to_string(num_writers++);
+  }
+  if (!writer.segment || writer.segment->capacity() < str.size()) {
+    // Readers keep their mapping of the old segment until they see a handle
+    // with the new generation. The old segment stays linked until the
+    // generation after this one, since its handle remains in Redis until the
+    // new handle is sent, and readers that GET it meanwhile must still be able
+    // to open it. Older generations have been superseded by then.
+    const size_t capacity =
+        std::max(str.size(), writer.segment ? 2 * writer.segment->capacity()
+                                            : size_t{0});
+    writer.previous = std::move(writer.segment);
+    writer.segment = std::make_unique<SharedMemorySegment>(
+        writer.prefix + "." + std::to_string(writer.generation++), capacity);
+  }
+  const uint64_t seq = writer.segment->Write(str.data(), str.size());
+
+  str = kSharedMemoryPrefix + HostName() + " " + writer.segment->name() +
+        " " + std::to_string(seq);
+}
+
+inline void RedisClient::ReadSharedMemory(const std::string& handle,
+                                          std::string& str) {
+  // Parse "\0shm <host> <name> <seq>".
+  const size_t idx_host = kSharedMemoryPrefix.size();
+  const size_t idx_name = handle.find(' ', idx_host) + 1;
+  const size_t idx_seq = handle.find(' ', idx_name) + 1;
+  if (idx_name == 0 || idx_seq == 0) {
+    throw std::runtime_error(
+        "RedisClient::ReadSharedMemory(): Invalid shared-memory handle.");
+  }
+  const std::string host = handle.substr(idx_host, idx_name - 1 - idx_host);
+  if (host != HostName()) {
+    throw std::runtime_error(
+        "RedisClient::ReadSharedMemory(): Value is in shared memory on host " +
+        host + ".");
+  }
+  const std::string name = handle.substr(idx_name, idx_seq - 1 - idx_name);
+
+  // Map each writer's segment once per process, replacing it when the writer
+  // allocates a new generation.
+  static std::mutex mtx_segments;
+  static std::unordered_map<std::string, std::shared_ptr<SharedMemorySegment>>
+      segments;
+  const std::string prefix = name.substr(0, name.rfind('.'));
+  std::shared_ptr<SharedMemorySegment> segment;
+  {
+    std::unique_lock<std::mutex> lock(mtx_segments);
+    std::shared_ptr<SharedMemorySegment>& cached = segments[prefix];
+    if (!cached || cached->name() != name) {
+      cached = std::make_shared<SharedMemorySegment>(name);
+    }
+    segment = cached;
+  }
+  segment->Read(str);
+}
+
+inline const std::string& RedisClient::HostName() {
+  static const std::string host_name = []() {
+    char buffer[256] = {};
+    gethostname(buffer, sizeof(buffer) - 1);
+    return std::string(buffer);
+  }();
+  return host_name;
+}
+
+inline std::shared_future<void> RedisClient::SubscribeChannel(
+    const std::string& channel, bool is_pattern) {
+  auto promise = std::make_shared<std::promise<void>>();
+  std::shared_future<void> subscribed;
+  {
+    std::unique_lock<std::mutex> lock(mtx_channels_);
+    Channel& state = is_pattern ? patterns_[channel] : channels_[channel];
+    if (state.subscribed.valid()) return state.subscribed;
+    state.subscribed = promise->get_future().share();
+    subscribed = state.subscribed;
+  }
+
+  // Subscribe to the channel until unsubscribe() or punsubscribe().
+  auto acknowledge_callback = [promise](int64_t) mutable {
+    if (!promise) return;
+    promise->set_value();
+    promise.reset();
+  };
+  cpp_redis::subscriber& subscriber = ConnectSubscriber();
+  if (is_pattern) {
+    subscriber.psubscribe(
+        channel,
+        [this, channel](const std::string& key, const std::string& message) {
+          OnPatternMessage(channel, key, message);
+        },
+        std::move(acknowledge_callback));
+  } else {
+    subscriber.subscribe(
+        channel,
+        [this](const std::string& key, const std::string& message) {
+          OnMessage(key, message);
+        },
+        std::move(acknowledge_callback));
+  }
+  subscriber.commit();
+  return subscribed;
 }
 
-template <class... Ts, class... Strings, typename>
-std::future<std::tuple<Ts...>> RedisClient::mget(const Strings&... keys) {
-  static_assert(sizeof...(Ts) == sizeof...(Strings),
-                "Number of keys must equal number of output types.");
+inline uint64_t RedisClient::AddRequest(
+    const std::string& channel,
+    std::function<void(const std::string&)>&& callback,
+    std::shared_future<void>& subscribed) {
+  std::unique_lock<std::mutex> lock_subscriber(mtx_subscriber_);
+  std::unique_lock<std::mutex> lock(mtx_channels_);
+  Channel& state = channels_[channel];
+  state.is_unsubscribed = false;
+  state.DropExpiredRequests(Clock::now());
 
-  auto promise = std::make_shared<std::promise<std::tuple<Ts...>>>();
-  // const std::array<std::string, sizeof...(Ts)> keys = {{ keys... }};
-  // mget<Ts...>(keys, [promise](Ts&&... values) {
-  //   promise->set_value(std::tuple<Ts...>{ values... });
-  // }, [promise](const std::string& error) {
-  //   promise->set_exception(std::make_exception_ptr(std::runtime_error(error)));
-  // });
-  std::vector<std::string> command = {"MGET", keys...};
-  send(command, [this, command, promise](cpp_redis::reply& reply) {
-    if (!reply.is_array()) {
-      std::stringstream ss_error(
-          "RedisClient::mget(): Failed to get values from keys:");
-      for (size_t i = 1; i < command.size(); i++) ss_error << " " << command[i];
-      ss_error << ".";
-      promise->set_exception(
-          std::make_exception_ptr(std::runtime_error(ss_error.str())));
-      return;
+  const uint64_t request_id = next_request_id_++;
+  state.requests.push_back({request_id, std::move(callback)});
+  lock.unlock();
+
+  subscribed = SubscribeChannel(channel, false);
+  return request_id;
+}
+
+inline void RedisClient::CancelRequest(const std::string& channel,
+                                       uint64_t request_id) {
+  std::unique_lock<std::mutex> lock_subscriber(mtx_subscriber_);
+  {
+    std::unique_lock<std::mutex> lock(mtx_channels_);
+    auto it = channels_.find(channel);
+    if (it == channels_.end()) return;
+    for (PendingRequest& request : it->second.requests) {
+      if (request.id != request_id) continue;
+      request.callback = nullptr;
+      request.expiry = Clock::now() + late_response_timeout_;
     }
-    std::tuple<Ts...> values;
+  }
+  UnsubscribeChannel(channel, false);
+}
+
+template <typename T>
+RedisClient& RedisClient::subscribe(
+    const std::string& channel, std::function<void(T&&)> callback,
+    SubscriptionMode mode,
+    std::function<void(const std::string&)> error_callback) {
+  auto subscription = std::make_shared<Subscription>();
+  subscription->mode = mode;
+  subscription->deliver = [callback = std::move(callback),
+                           error_callback = std::move(error_callback)](
+                              const std::string& key,
+                              const std::string& message) {
     try {
-      RepliesToTuple(reply.as_array(), values,
-                     std::index_sequence_for<Ts...>{});
+      callback(Decode<T>(message));
     } catch (const std::exception& e) {
-      std::stringstream ss_error(
-          "RedisClient::mget(): Failed to get values from keys:");
-      for (size_t i = 1; i < command.size(); i++) ss_error << " " << command[i];
-      ss_error << ".";
-      promise->set_exception(
-          std::make_exception_ptr(std::runtime_error(ss_error.str())));
-      return;
+      if (error_callback) {
+        error_callback("RedisClient::subscribe(): Exception thrown on key: " +
+                       key + "\n\t" + e.what());
+      }
     }
-    promise->set_value(std::move(values));
-  });
-  return promise->get_future();
+  };
+  AddSubscription(channel, false, std::move(subscription));
+  return *this;
 }
 
 template <typename T>
-std::future<std::vector<T>> RedisClient::mget(
-    const std::vector<std::string>& keys) {
-  auto promise = std::make_shared<std::promise<std::vector<T>>>();
-  std::vector<std::string> command(keys.size() + 1);
-  command[0] = "MGET";
-  std::copy(keys.begin(), keys.end(), command.begin() + 1);
-  send(command, [this, command, promise](cpp_redis::reply& reply) {
-    if (!reply.is_array()) {
-      std::stringstream ss_error(
-          "RedisClient::mget(): Failed to get values from keys:");
-      for (size_t i = 1; i < command.size(); i++) ss_error << " " << command[i];
-      ss_error << ".";
-      promise->set_exception(
-          std::make_exception_ptr(std::runtime_error(ss_error.str())));
-      return;
-    }
-    std::vector<T> values;
-    values.reserve(reply.as_array().size());
+RedisClient& RedisClient::psubscribe(
+    const std::string& pattern,
+    std::function<void(const std::string&, T&&)> callback,
+    SubscriptionMode mode,
+    std::function<void(const std::string&)> error_callback) {
+  auto subscription = std::make_shared<Subscription>();
+  subscription->mode = mode;
+  subscription->deliver = [callback = std::move(callback),
+                           error_callback = std::move(error_callback)](
+                              const std::string& key,
+                              const std::string& message) {
     try {
-      for (const cpp_redis::reply& r : reply.as_array()) {
-        values.push_back(FromString<T>(r.as_string()));
-      }
+      callback(key, Decode<T>(message));
     } catch (const std::exception& e) {
-      std::stringstream ss_error(
-          "RedisClient::mget(): Failed to get values from keys:");
-      for (size_t i = 1; i < command.size(); i++) ss_error << " " << command[i];
-      ss_error << ".";
-      promise->set_exception(
-          std::make_exception_ptr(std::runtime_error(ss_error.str())));
-      return;
+      if (error_callback) {
+        error_callback("RedisClient::psubscribe(): Exception thrown on key: " +
+                       key + "\n\t" + e.what());
+      }
     }
-    promise->set_value(std::move(values));
-  });
-  return promise->get_future();
+  };
+  AddSubscription(pattern, true, std::move(subscription));
+  return *this;
 }
 
-template <class... Ts, class... Args, typename>
-std::tuple<Ts...> RedisClient::sync_mget(const Args&... args) {
-  std::future<std::tuple<Ts...>> future = mget<Ts...>(args...);
-  commit();
-  return future.get();
+inline RedisClient& RedisClient::unsubscribe(const std::string& channel) {
+  std::unique_lock<std::mutex> lock_subscriber(mtx_subscriber_);
+  {
+    std::unique_lock<std::mutex> lock(mtx_channels_);
+    const auto it = channels_.find(channel);
+    if (it == channels_.end()) return *this;
+    it->second.subscriptions.clear();
+    it->second.is_unsubscribed = true;
+  }
+  UnsubscribeChannel(channel, false);
+  return *this;
 }
 
-template <typename T>
-std::vector<T> RedisClient::sync_mget(const std::vector<std::string>& keys) {
-  std::future<std::vector<T>> future = mget<T>(keys);
-  commit();
-  return future.get();
+inline RedisClient& RedisClient::punsubscribe(const std::string& pattern) {
+  std::unique_lock<std::mutex> lock_subscriber(mtx_subscriber_);
+  {
+    std::unique_lock<std::mutex> lock(mtx_channels_);
+    const auto it = patterns_.find(pattern);
+    if (it == patterns_.end()) return *this;
+    it->second.subscriptions.clear();
+    it->second.is_unsubscribed = true;
+  }
+  UnsubscribeChannel(pattern, true);
+  return *this;
 }
 
-// template<typename Func, typename Tuple, size_t... Is>
-// void Apply(const Func& func, Tuple&& values, std::index_sequence<Is...>) {
-//   func(std::move(std::get<Is>(values))...);
-// }
+inline void RedisClient::UnsubscribeChannel(const std::string& channel,
+                                            bool is_pattern) {
+  bool is_subscribed;
+  {
+    std::unique_lock<std::mutex> lock(mtx_channels_);
+    std::unordered_map<std::string, Channel>& states =
+        is_pattern ? patterns_ : channels_;
+    const auto it = states.find(channel);
+    if (it == states.end() || !it->second.is_unsubscribed ||
+        !it->second.IsIdle()) {
+      return;
+    }
+    is_subscribed = it->second.subscribed.valid();
+    states.erase(it);
+  }
 
-// template<class... Ts>
-// RedisClient& RedisClient::mget(const std::array<std::string, sizeof...(Ts)>&
-// keys,
-//                                const std::function<void(std::tuple<Ts...>&&)>
-//                                reply_callback, const std::function<void(const
-//                                std::string&)>& error_callback) {
+  // The subscriber is null while the client is being destroyed.
+  if (!is_subscribed || !subscriber_) return;
+  if (is_pattern) {
+    subscriber_->punsubscribe(channel);
+  } else {
+    subscriber_->unsubscribe(channel);
+  }
+  subscriber_->commit();
+}
 
-//   std::vector<std::string> command = {"MGET", args...};
-//   send(command, [command, reply_callback, error_callback](cpp_redis::reply&
-//   reply) {
-//     if (!reply.is_array()) {
-//       std::stringstream ss_error("RedisClient::mget(): Failed to get values
-//       from keys:"); for (size_t i = 1; i < command.size(); i++) ss_error << "
-//       " << command[i]; ss_error << "."; error_callback(ss_error.str());
-//       return;
-//     }
-//     std::tuple<Ts...> values;
-//     try {
-//       RepliesToTuple(reply.as_array(), values,
-//       std::index_sequence_for<Ts...>{});
-//     } catch (const std::exception& e) {
-//       std::stringstream ss_error("RedisClient::mget(): Failed to get values
-//       from keys:"); for (size_t i = 1; i < command.size(); i++) ss_error << "
-//       " << command[i]; ss_error << "."; error_callback(ss_error.str());
-//       return;
-//     }
-//     // Apply(reply_callback, values, std::index_sequence_for<Ts...>{});
-//   });
-//   return *this;
-// }
+inline ThreadPool<void>& RedisClient::SubscriberPool() {
+  if (!subscriber_pool_) {
+    subscriber_pool_ =
+        std::make_unique<ThreadPool<void>>(num_subscriber_threads_);
+  }
+  return *subscriber_pool_;
+}
 
-template <typename T>
-RedisClient& RedisClient::mset(
-    const std::vector<std::pair<std::string, T>>& key_vals,
-    const reply_callback_t& reply_callback) {
-  std::vector<std::string> command;
-  command.reserve(2 * key_vals.size() + 1);
-  command.push_back("MSET");
-  for (const std::pair<std::string, T>& key_val : key_vals) {
-    command.push_back(key_val.first);
-    command.push_back(ToString(key_val.second));
+inline void RedisClient::AddSubscription(
+    const std::string& channel, bool is_pattern,
+    std::shared_ptr<Subscription>&& subscription) {
+  std::unique_lock<std::mutex> lock_subscriber(mtx_subscriber_);
+  {
+    std::unique_lock<std::mutex> lock(mtx_channels_);
+    SubscriberPool();
+    Channel& state = is_pattern ? patterns_[channel] : channels_[channel];
+    state.is_unsubscribed = false;
+    state.subscriptions.push_back(std::move(subscription));
   }
-  send(command, reply_callback);
-  return *this;
+  const std::shared_future<void> subscribed =
+      SubscribeChannel(channel, is_pattern);
+
+  lock_subscriber.unlock();
+  subscribed.wait();
 }
 
-template <typename T>
-std::future<cpp_redis::reply> RedisClient::mset(
-    const std::vector<std::pair<std::string, T>>& key_vals) {
-  auto promise = std::make_shared<std::promise<cpp_redis::reply>>();
-  mset(key_vals, [promise](cpp_redis::reply& reply) {
-    if (reply) {
-      promise->set_value(reply);
+inline void RedisClient::Dispatch(
+    const std::shared_ptr<Subscription>& subscription,
+    const std::string& channel, const std::string& message) {
+  {
+    std::unique_lock<std::mutex> lock(subscription->mtx);
+    std::deque<std::pair<std::string, std::string>>& messages =
+        subscription->messages;
+    auto it = messages.end();
+    if (subscription->mode == SubscriptionMode::kLatest) {
+      // Replace the undelivered message of the channel. Patterns keep one
+      // message per matching channel.
+      it = std::find_if(messages.begin(), messages.end(),
+                        [&channel](const std::pair<std::string, std::string>&
+                                       channel_message) {
+                          return channel_message.first == channel;
+                        });
+    }
+    if (it != messages.end()) {
+      it->second = message;
     } else {
-      promise->set_exception(
-          std::make_exception_ptr(std::runtime_error(reply.error())));
+      messages.emplace_back(channel, message);
     }
-  });
-  return promise->get_future();
+    if (subscription->is_scheduled) return;
+    subscription->is_scheduled = true;
+  }
+  subscriber_pool_->Submit([this, subscription]() { Deliver(subscription); });
 }
 
-template <typename T>
-cpp_redis::reply RedisClient::sync_mset(
-    const std::vector<std::pair<std::string, T>>& key_vals) {
-  std::future<cpp_redis::reply> future = mset(key_vals);
-  commit();
-  return future.get();
-}
+inline void RedisClient::Deliver(
+    const std::shared_ptr<Subscription>& subscription) {
+  // Deliver the messages that are queued now, and then yield the thread to
+  // other subscriptions.
+  size_t num_messages;
+  {
+    std::unique_lock<std::mutex> lock(subscription->mtx);
+    num_messages = subscription->messages.size();
+  }
+  for (size_t i = 0; i < num_messages; i++) {
+    std::pair<std::string, std::string> channel_message;
+    {
+      std::unique_lock<std::mutex> lock(subscription->mtx);
+      if (subscription->messages.empty()) break;
+      channel_message = std::move(subscription->messages.front());
+      subscription->messages.pop_front();
+    }
+    subscription->deliver(channel_message.first, channel_message.second);
+  }
 
-template <typename T>
-RedisClient& RedisClient::publish(const std::string& key, const T& value,
-                                  const reply_callback_t& reply_callback) {
-  std::string str;
-  ToString(str, value);
-  cpp_redis::client::publish(key, str, reply_callback);
-  return *this;
+  {
+    std::unique_lock<std::mutex> lock(subscription->mtx);
+    if (subscription->messages.empty()) {
+      subscription->is_scheduled = false;
+      return;
+    }
+  }
+  subscriber_pool_->Submit([this, subscription]() { Deliver(subscription); });
 }
 
-template <typename T>
-RedisClient& RedisClient::hset(const std::string& key, const std::string& field,
-                               const T& value,
-                               const reply_callback_t& reply_callback) {
-  std::string str;
-  ToString(str, value);
-  cpp_redis::client::hset(key, field, str, reply_callback);
-  return *this;
-}
+inline void RedisClient::OnMessage(const std::string& channel,
+                                   const std::string& message) {
+  std::function<void(const std::string&)> callback;
+  {
+    std::unique_lock<std::mutex> lock(mtx_channels_);
+    auto it = channels_.find(channel);
+    if (it == channels_.end()) return;
+    for (const std::shared_ptr<Subscription>& subscription :
+         it->second.subscriptions) {
+      Dispatch(subscription, channel, message);
+    }
+    it->second.DropExpiredRequests(Clock::now());
+    if (it->second.requests.empty()) return;
+    callback = std::move(it->second.requests.front().callback);
+    it->second.requests.pop_front();
 
-template <typename T>
-std::future<cpp_redis::reply> RedisClient::hset(const std::string& key,
-                                                const std::string& field,
-                                                const T& value) {
-  std::string str;
-  ToString(str, value);
-  return cpp_redis::client::hset(key, field, str);
+    // The subscriber cannot unsubscribe from within its own callback.
+    if (it->second.is_unsubscribed && it->second.IsIdle()) {
+      SubscriberPool().Submit([this, channel]() {
+        std::unique_lock<std::mutex> lock_subscriber(mtx_subscriber_);
+        UnsubscribeChannel(channel, false);
+      });
+    }
+  }
+  // Timed out requests discard their responses.
+  if (callback) callback(message);
 }
 
-template <typename T>
-cpp_redis::reply RedisClient::sync_hset(const std::string& key,
-                                        const std::string& field,
-                                        const T& value) {
-  std::future<cpp_redis::reply> future = hset(key, field, value);
-  commit();
-  return future.get();
-};
-
-template <typename T>
-std::future<cpp_redis::reply> RedisClient::publish(const std::string& key,
-                                                   const T& value) {
-  std::string str;
-  ToString(str, value);
-  return cpp_redis::client::publish(key, str);
+inline void RedisClient::OnPatternMessage(const std::string& pattern,
+                                          const std::string& channel,
+                                          const std::string& message) {
+  std::unique_lock<std::mutex> lock(mtx_channels_);
+  auto it = patterns_.find(pattern);
+  if (it == patterns_.end()) return;
+  for (const std::shared_ptr<Subscription>& subscription :
+       it->second.subscriptions) {
+    Dispatch(subscription, channel, message);
+  }
 }
 
-template <typename T>
-cpp_redis::reply RedisClient::sync_publish(const std::string& key,
-                                           const T& value) {
-  std::future<cpp_redis::reply> future = publish(key, value);
-  commit();
-  return future.get();
-};
-
 template <typename TSub, typename TPub>
-RedisClient& RedisClient::request(const std::string& key_pub,
-                                  const TPub& value_pub,
-                                  const std::string& key_sub,
-                                  std::function<void(TSub&&)>&& sub_callback) {
-  auto sub = std::make_shared<cpp_redis::subscriber>();
-  sub->connect(host_, port_);
-
-  sub->subscribe(key_sub, [sub, sub_callback = std::move(sub_callback)](
-                              const std::string& key,
-                              const std::string& str_value) mutable {
-    sub_callback(FromString<TSub>(str_value));
-    std::thread([sub = std::move(sub), key]() mutable {
-      sub->unsubscribe(key);
-      sub->commit();
-    }).detach();
-  });
-  sub->commit();
+RedisClient& RedisClient::request(
+    const std::string& key_pub, const TPub& value_pub,
+    const std::string& key_sub, std::function<void(TSub&&)>&& sub_callback,
+    std::function<void(const std::string&)>&& error_callback) {
+  std::shared_future<void> subscribed;
+  AddRequest(key_sub,
+             [key_sub, sub_callback = std::move(sub_callback),
+              error_callback = std::move(error_callback)](
+                 const std::string& str_value) {
+               TSub value;
+               try {
+                 Decode(str_value, value);
+               } catch (const std::exception& e) {
+                 if (error_callback) {
+                   error_callback(
+                       "RedisClient::request(): Exception thrown on key: " +
+                       key_sub + "\n\t" + e.what());
+                 }
+                 return;
+               }
+               sub_callback(std::move(value));
+             },
+             subscribed);
 
+  // Wait for the subscription so that the response isn't missed.
+  subscribed.wait();
   publish(key_pub, value_pub);
   return *this;
 }
 
+template <typename TSub>
+std::function<void(const std::string&)> RedisClient::ResolveRequest(
+    const std::shared_ptr<std::promise<TSub>>& promise,
+    const std::string& key_sub) {
+  return [promise, key_sub](const std::string& str_value) {
+    try {
+      promise->set_value(Decode<TSub>(str_value));
+    } catch (const std::exception& e) {
+      const std::string error =
+          "RedisClient::request(): Exception thrown on key: " + key_sub +
+          "\n\t" + e.what();
+      promise->set_exception(
+          std::make_exception_ptr(std::runtime_error(error)));
+    }
+  };
+}
+
 template <typename TSub, typename TPub>
 std::future<TSub> RedisClient::request(const std::string& key_pub,
                                        const TPub& value_pub,
                                        const std::string& key_sub) {
   auto promise = std::make_shared<std::promise<TSub>>();
-  request<TSub>(key_pub, value_pub, key_sub, [promise](TSub&& value) mutable {
-    if (!promise) return;
-    promise->set_value(std::move(value));
-    promise.reset();
-  });
+  std::shared_future<void> subscribed;
+  AddRequest(key_sub, ResolveRequest(promise, key_sub), subscribed);
+
+  // Wait for the subscription so that the response isn't missed.
+  subscribed.wait();
+  publish(key_pub, value_pub);
   return promise->get_future();
 }
 
+template <typename TSub, typename TPub, typename Deadline>
+bool RedisClient::RequestUntil(const std::string& key_pub,
+                               const TPub& value_pub,
+                               const std::string& key_sub,
+                               const Deadline& deadline,
+                               std::future<TSub>& fut_value) {
+  auto promise = std::make_shared<std::promise<TSub>>();
+  fut_value = promise->get_future();
+  std::shared_future<void> subscribed;
+  const uint64_t request_id =
+      AddRequest(key_sub, ResolveRequest(promise, key_sub), subscribed);
+  if (!WaitFor(subscribed, deadline)) {
+    CancelRequest(key_sub, request_id);
+    return false;
+  }
+
+  publish(key_pub, value_pub);
+  commit();
+  if (!WaitFor(fut_value, deadline)) {
+    CancelRequest(key_sub, request_id);
+    return false;
+  }
+  return true;
+}
+
 template <typename TSub, typename TPub>
 TSub RedisClient::sync_request(const std::string& key_pub,
                                const TPub& value_pub,
@@ -923,71 +4476,121 @@ TSub RedisClient::sync_request(const std::string& key_pub,
   return fut_value.get();
 }
 
-inline RedisClient& RedisClient::scan(
-    size_t cursor, const std::string& pattern,
-    std::unordered_set<std::string>&& keys,
-    std::function<void(std::unordered_set<std::string>&&)>&& callback) {
-  cpp_redis::client::scan(
-      cursor, pattern,
-      [this, pattern, keys = std::move(keys),
-       callback = std::move(callback)](cpp_redis::reply& reply) mutable {
-        // Parse reply array
-        if (!reply.is_array()) {
-          throw std::runtime_error("RedisClient::scan(): Invalid reply.");
-        }
-        const std::vector<cpp_redis::reply> replies = reply.as_array();
+template <typename TSub, typename TPub, typename Timeout>
+TSub RedisClient::sync_request(const std::string& key_pub,
+                               const TPub& value_pub,
+                               const std::string& key_sub,
+                               const Timeout& timeout) {
+  std::future<TSub> fut_value;
+  if (!RequestUntil(key_pub, value_pub, key_sub, ToDeadline(timeout),
+                    fut_value)) {
+    throw std::runtime_error(
+        "RedisClient::sync_request(): Timed out waiting for response on key: " +
+        key_sub + ".");
+  }
+  return fut_value.get();
+}
 
-        // Parse cursor, keys array
-        if (replies.size() != 2 || !replies[0].is_string() ||
-            !replies[1].is_array()) {
-          throw std::runtime_error("RedisClient::scan(): Invalid reply.");
-        }
+template <typename TSub, typename TPub, typename Timeout>
+bool RedisClient::sync_request(const std::string& key_pub,
+                               const TPub& value_pub,
+                               const std::string& key_sub, TSub& value_sub,
+                               const Timeout& timeout) {
+  std::future<TSub> fut_value;
+  return RequestUntil(key_pub, value_pub, key_sub, ToDeadline(timeout),
+                      fut_value) &&
+         TryGet(fut_value, value_sub);
+}
 
-        // Parse cursor
-        if (replies.size() < 1 || !replies[0].is_string()) {
-          throw std::runtime_error("RedisClient::scan(): Invalid reply.");
-        }
-        size_t cursor_next = FromString<size_t>(replies[0].as_string());
-        if (cursor_next == 0) {
-          callback(std::move(keys));
-          return;
-        }
+inline void RedisClient::ScanCursor(const std::string& cursor,
+                                    const std::shared_ptr<ScanState>& state) {
+  std::vector<std::string> command = {"SCAN", cursor, "MATCH", state->pattern};
+  if (state->count > 0) {
+    command.push_back("COUNT");
+    command.push_back(std::to_string(state->count));
+  }
+  if (!state->type.empty()) {
+    command.push_back("TYPE");
+    command.push_back(state->type);
+  }
 
-        // Parse keys array
-        if (replies.size() < 2 || !replies[1].is_array()) {
-          throw std::runtime_error("RedisClient::scan(): Invalid reply.");
-        }
-        const std::vector<cpp_redis::reply> keys_batch = replies[1].as_array();
-
-        // Parse keys
-        for (const cpp_redis::reply& key : keys_batch) {
-          if (!key.is_string()) {
-            throw std::runtime_error("RedisClient::scan(): Invalid reply.");
-          }
-          keys.insert(key.as_string());
+  Send(command, [this, state](cpp_redis::reply& reply) {
+    // Parse cursor, keys array
+    if (!reply.is_array() || reply.as_array().size() != 2 ||
+        !reply.as_array()[0].is_string() || !reply.as_array()[1].is_array()) {
+      if (state->error_callback) {
+        state->error_callback("RedisClient::scan(): Invalid reply.");
+      }
+      return;
+    }
+    const std::vector<cpp_redis::reply>& replies = reply.as_array();
+
+    // Parse keys
+    const std::vector<cpp_redis::reply>& replies_keys = replies[1].as_array();
+    std::vector<std::string> keys;
+    keys.reserve(replies_keys.size());
+    for (const cpp_redis::reply& key : replies_keys) {
+      if (!key.is_string()) {
+        if (state->error_callback) {
+          state->error_callback("RedisClient::scan(): Invalid reply.");
         }
+        return;
+      }
+      keys.push_back(key.as_string());
+    }
 
-        scan(cursor_next, pattern, std::move(keys), std::move(callback));
-        commit();
-      });
+    // Request the next batch before processing this one
+    const bool is_done = replies[0].as_string() == "0";
+    if (!is_done) {
+      ScanCursor(replies[0].as_string(), state);
+      commit();
+    }
+
+    if (!keys.empty()) state->batch_callback(std::move(keys));
+    if (is_done && state->done_callback) state->done_callback();
+  });
+}
+
+inline RedisClient& RedisClient::scan(
+    const std::string& pattern, size_t count, const std::string& type,
+    std::function<void(std::vector<std::string>&&)>&& batch_callback,
+    std::function<void()>&& done_callback,
+    std::function<void(const std::string&)>&& error_callback) {
+  auto state = std::make_shared<ScanState>(
+      ScanState{pattern, count, type, std::move(batch_callback),
+                std::move(done_callback), std::move(error_callback)});
+  ScanCursor("0", state);
   return *this;
 }
 
 inline RedisClient& RedisClient::scan(
     const std::string& pattern,
-    std::function<void(std::unordered_set<std::string>&&)>&& callback) {
-  return scan(0, pattern, {}, std::move(callback));
+    std::function<void(std::unordered_set<std::string>&&)>&& callback,
+    std::function<void(const std::string&)>&& error_callback) {
+  auto keys = std::make_shared<std::unordered_set<std::string>>();
+  return scan(
+      pattern, 0, "",
+      [keys](std::vector<std::string>&& batch) {
+        keys->insert(std::make_move_iterator(batch.begin()),
+                     std::make_move_iterator(batch.end()));
+      },
+      [keys, callback = std::move(callback)]() { callback(std::move(*keys)); },
+      std::move(error_callback));
 }
 
 inline std::future<std::unordered_set<std::string>> RedisClient::scan(
     const std::string& pattern) {
   auto promise =
       std::make_shared<std::promise<std::unordered_set<std::string>>>();
-  scan(pattern, [promise](std::unordered_set<std::string>&& keys) mutable {
-    if (!promise) return;
-    promise->set_value(std::move(keys));
-    promise.reset();
-  });
+  scan(
+      pattern,
+      [promise](std::unordered_set<std::string>&& keys) {
+        promise->set_value(std::move(keys));
+      },
+      [promise](const std::string& error) {
+        promise->set_exception(
+            std::make_exception_ptr(std::runtime_error(error)));
+      });
   return promise->get_future();
 }
 
@@ -0,0 +1,349 @@
+/**
+ * redis_client_pool.h
+ *
+ * Copyright 2026. All Rights Reserved.
+ *
+ * Created: October 17, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef CTRL_UTILS_REDIS_CLIENT_POOL_H_
+#define CTRL_UTILS_REDIS_CLIENT_POOL_H_
+
+#include <functional>  // std::function, std::hash
+#include <future>      // std::future
+#include <memory>      // std::unique_ptr
+#include <stdexcept>   // std::invalid_argument
+#include <string>      // std::string
+#include <tuple>       // std::tuple
+#include <utility>     // std::pair
+#include <vector>      // std::vector
+
+#include "ctrl_utils/redis_client.h"
+#include "ctrl_utils/string.h"
+
+namespace ctrl_utils {
+
+/**
+ * Pool of RedisClient connections with key-based routing.
+ *
+ * Each command is sent on the connection selected by its key. Keys matching
+ * an affinity pattern always use the assigned connection, so bulk keys (e.g.
+ * images) can be kept off the connections used by small control keys. All
+ * other keys are distributed over the remaining connections by key hash.
+ *
+ * All connections talk to the same Redis server, so multi-key commands are
+ * routed by their first key.
+ *
+ * __Example__
+ * ~~~~~~~~~~ {.cc}
+ * ctrl_utils::RedisClientPool redis_pool(3);
+ * redis_pool.connect();
+ *
+ * // Send camera images on connection 0.
+ * redis_pool.set_affinity("camera::*", 0);
+ *
+ * // Control keys get distributed over connections 1 and 2.
+ * redis_pool.set("camera::rgb", img);
+ * redis_pool.set("robot::q", q);
+ * redis_pool.commit();
+ * ~~~~~~~~~~
+ */
+class RedisClientPool {
+ public:
+  /**
+   * Constructs a pool with the specified number of connections.
+   *
+   * @param num_connections Number of connections. Must be at least 1.
+   */
+  explicit RedisClientPool(size_t num_connections) {
+    if (num_connections == 0) {
+      throw std::invalid_argument(
+          "RedisClientPool(): Number of connections must be positive.");
+    }
+    clients_.reserve(num_connections);
+    for (size_t i = 0; i < num_connections; i++) {
+      clients_.push_back(std::make_unique<RedisClient>());
+    }
+    UpdateHashedClients();
+  }
+
+  /**
+   * Connects all the clients in the pool.
+   */
+  void connect(const std::string& host = "127.0.0.1", size_t port = 6379,
+               const std::string& password = "") {
+    for (std::unique_ptr<RedisClient>& client : clients_) {
+      client->connect(host, port, password);
+    }
+  }
+
+  /**
+   * @return Number of connections.
+   */
+  size_t size() const { return clients_.size(); }
+
+  /**
+   * @return Client at the given index.
+   */
+  RedisClient& client(size_t idx) { return *clients_.at(idx); }
+
+  /**
+   * @return Client selected for the given key.
+   */
+  RedisClient& client(const std::string& key) {
+    return *clients_[ConnectionIndex(key)];
+  }
+
+  /**
+   * Assigns keys matching the glob pattern to a connection.
+   *
+   * Patterns are checked in the order they are added. Connections with
+   * assigned patterns are excluded from hash-based routing unless every
+   * connection has an assigned pattern.
+   *
+   * @param pattern Redis glob pattern (supports '*' and '?').
+   * @param idx_connection Index of the connection.
+   */
+  void set_affinity(const std::string& pattern, size_t idx_connection) {
+    if (idx_connection >= clients_.size()) {
+      throw std::invalid_argument(
+          "RedisClientPool::set_affinity(): Invalid connection index " +
+          std::to_string(idx_connection) + ".");
+    }
+    affinities_.emplace_back(pattern, idx_connection);
+    UpdateHashedClients();
+  }
+
+  /**
+   * Returns the index of the connection used for the given key.
+   */
+  size_t ConnectionIndex(const std::string& key) const {
+    for (const std::pair<std::string, size_t>& affinity : affinities_) {
+      if (MatchGlob(affinity.first, key)) return affinity.second;
+    }
+    return idx_hashed_[std::hash<std::string>{}(key) % idx_hashed_.size()];
+  }
+
+  /**
+   * Sets the codec on all connections (see RedisClient::set_codec()).
+   */
+  void set_codec(RedisClient::Codec codec) {
+    for (std::unique_ptr<RedisClient>& client : clients_) {
+      client->set_codec(codec);
+    }
+  }
+
+  /**
+   * Sets the codec for a key (see RedisClient::set_codec()).
+   */
+  void set_codec(const std::string& key, RedisClient::Codec codec) {
+    client(key).set_codec(key, codec);
+  }
+
+  /**
+   * Sets the pipeline policy on all connections (see
+   * RedisClient::set_pipeline_policy()).
+   */
+  void set_pipeline_policy(const RedisClient::PipelinePolicy& policy) {
+    for (std::unique_ptr<RedisClient>& client : clients_) {
+      client->set_pipeline_policy(policy);
+    }
+  }
+
+  /**
+   * Sends all pending commands on all connections.
+   */
+  RedisClientPool& commit() {
+    for (std::unique_ptr<RedisClient>& client : clients_) client->commit();
+    return *this;
+  }
+
+  /**
+   * Sends all pending commands on all connections and waits for all replies.
+   */
+  RedisClientPool& sync_commit() {
+    for (std::unique_ptr<RedisClient>& client : clients_) client->commit();
+    for (std::unique_ptr<RedisClient>& client : clients_) {
+      client->sync_commit();
+    }
+    return *this;
+  }
+
+  /// @see RedisClient::get()
+  template <typename T>
+  std::future<T> get(const std::string& key) {
+    return client(key).get<T>(key);
+  }
+
+  /// @see RedisClient::get()
+  template <typename T>
+  std::future<void> get(const std::string& key, T& value) {
+    return client(key).get(key, value);
+  }
+
+  /// @see RedisClient::get()
+  template <typename T>
+  RedisClientPool& get(
+      const std::string& key, const std::function<void(T&&)>& reply_callback,
+      const std::function<void(const std::string&)>& error_callback = {}) {
+    client(key).get<T>(key, reply_callback, error_callback);
+    return *this;
+  }
+
+  /// @see RedisClient::sync_get()
+  template <typename T>
+  T sync_get(const std::string& key) {
+    return client(key).sync_get<T>(key);
+  }
+
+  /// @see RedisClient::set()
+  template <typename T>
+  std::future<cpp_redis::reply> set(const std::string& key, const T& value) {
+    return client(key).set(key, value);
+  }
+
+  /// @see RedisClient::set()
+  template <typename T>
+  RedisClientPool& set(const std::string& key, const T& value,
+                       const RedisClient::reply_callback_t& reply_callback) {
+    client(key).set(key, value, reply_callback);
+    return *this;
+  }
+
+  /// @see RedisClient::sync_set()
+  template <typename T>
+  cpp_redis::reply sync_set(const std::string& key, const T& value) {
+    return client(key).sync_set(key, value);
+  }
+
+  /// @see RedisClient::mget()
+  template <class... Ts, class... Strings>
+  std::future<std::tuple<Ts...>> mget(const std::string& key,
+                                      const Strings&... keys) {
+    return client(key).mget<Ts...>(key, keys...);
+  }
+
+  /// @see RedisClient::mget()
+  template <typename T>
+  std::future<std::vector<T>> mget(const std::vector<std::string>& keys) {
+    return RouteKeys(keys).mget<T>(keys);
+  }
+
+  /// @see RedisClient::sync_mget()
+  template <class... Ts, class... Strings>
+  std::tuple<Ts...> sync_mget(const std::string& key, const Strings&... keys) {
+    return client(key).sync_mget<Ts...>(key, keys...);
+  }
+
+  /// @see RedisClient::sync_mget()
+  template <typename T>
+  std::vector<T> sync_mget(const std::vector<std::string>& keys) {
+    return RouteKeys(keys).sync_mget<T>(keys);
+  }
+
+  /// @see RedisClient::mset()
+  template <class Pair, class... Pairs>
+  std::future<cpp_redis::reply> mset(const Pair& key_val,
+                                     const Pairs&... key_vals) {
+    return client(key_val.first).mset(key_val, key_vals...);
+  }
+
+  /// @see RedisClient::mset()
+  template <typename T>
+  std::future<cpp_redis::reply> mset(
+      const std::vector<std::pair<std::string, T>>& key_vals) {
+    return RouteKeyvals(key_vals).mset(key_vals);
+  }
+
+  /// @see RedisClient::sync_mset()
+  template <class Pair, class... Pairs>
+  cpp_redis::reply sync_mset(const Pair& key_val, const Pairs&... key_vals) {
+    return client(key_val.first).sync_mset(key_val, key_vals...);
+  }
+
+  /// @see RedisClient::sync_mset()
+  template <typename T>
+  cpp_redis::reply sync_mset(
+      const std::vector<std::pair<std::string, T>>& key_vals) {
+    return RouteKeyvals(key_vals).sync_mset(key_vals);
+  }
+
+  /// @see RedisClient::hset()
+  template <typename T>
+  std::future<cpp_redis::reply> hset(const std::string& key,
+                                     const std::string& field, const T& value) {
+    return client(key).hset(key, field, value);
+  }
+
+  /// @see RedisClient::sync_hset()
+  template <typename T>
+  cpp_redis::reply sync_hset(const std::string& key, const std::string& field,
+                             const T& value) {
+    return client(key).sync_hset(key, field, value);
+  }
+
+  /// @see RedisClient::publish()
+  template <typename T>
+  std::future<cpp_redis::reply> publish(const std::string& key,
+                                        const T& value) {
+    return client(key).publish(key, value);
+  }
+
+  /// @see RedisClient::sync_publish()
+  template <typename T>
+  cpp_redis::reply sync_publish(const std::string& key, const T& value) {
+    return client(key).sync_publish(key, value);
+  }
+
+  /// @see RedisClient::request()
+  template <typename TSub, typename TPub>
+  std::future<TSub> request(const std::string& key_pub, const TPub& value_pub,
+                            const std::string& key_sub) {
+    return client(key_pub).request<TSub>(key_pub, value_pub, key_sub);
+  }
+
+  /// @see RedisClient::sync_request()
+  template <typename TSub, typename TPub>
+  TSub sync_request(const std::string& key_pub, const TPub& value_pub,
+                    const std::string& key_sub) {
+    return client(key_pub).sync_request<TSub>(key_pub, value_pub, key_sub);
+  }
+
+ private:
+  RedisClient& RouteKeys(const std::vector<std::string>& keys) {
+    return keys.empty() ? *clients_.front() : client(keys.front());
+  }
+
+  template <typename T>
+  RedisClient& RouteKeyvals(
+      const std::vector<std::pair<std::string, T>>& key_vals) {
+    return key_vals.empty() ? *clients_.front() : client(key_vals.front().first);
+  }
+
+  /**
+   * Collects the connections without an assigned pattern for hash routing.
+   */
+  void UpdateHashedClients() {
+    std::vector<bool> is_assigned(clients_.size(), false);
+    for (const std::pair<std::string, size_t>& affinity : affinities_) {
+      is_assigned[affinity.second] = true;
+    }
+
+    idx_hashed_.clear();
+    for (size_t i = 0; i < clients_.size(); i++) {
+      if (!is_assigned[i]) idx_hashed_.push_back(i);
+    }
+    if (idx_hashed_.empty()) {
+      for (size_t i = 0; i < clients_.size(); i++) idx_hashed_.push_back(i);
+    }
+  }
+
+  std::vector<std::unique_ptr<RedisClient>> clients_;
+  std::vector<std::pair<std::string, size_t>> affinities_;
+  std::vector<size_t> idx_hashed_;
+};
+
+}  // namespace ctrl_utils
+
+#endif  // CTRL_UTILS_REDIS_CLIENT_POOL_H_
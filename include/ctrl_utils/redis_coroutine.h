@@ -0,0 +1,459 @@
+/**
+ * redis_coroutine.h
+ *
+ * Copyright 2026. All Rights Reserved.
+ *
+ * Created: October 17, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef CTRL_UTILS_REDIS_COROUTINE_H_
+#define CTRL_UTILS_REDIS_COROUTINE_H_
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+
+#include <atomic>         // std::atomic
+#include <coroutine>      // std::coroutine_handle, std::suspend_never
+#include <exception>      // std::exception_ptr, std::rethrow_exception
+#include <functional>     // std::function
+#include <memory>         // std::shared_ptr
+#include <optional>       // std::optional
+#include <stdexcept>      // std::runtime_error
+#include <string>         // std::string
+#include <unordered_set>  // std::unordered_set
+#include <utility>        // std::move
+#include <vector>         // std::vector
+
+#include "ctrl_utils/redis_client.h"
+
+namespace ctrl_utils {
+
+/**
+ * Resumes a suspended coroutine, for example by posting it to a thread pool.
+ *
+ * If no executor is given, coroutines resume on the cpp_redis reply thread.
+ * Code running there must not block, since it delays all other replies.
+ *
+ * __Example__
+ * ~~~~~~~~~~ {.cc}
+ * ctrl_utils::ThreadPool<void> pool(4);
+ * ctrl_utils::RedisExecutor executor = [&pool](std::coroutine_handle<> h) {
+ *   pool.Submit([h]() { h.resume(); });
+ * };
+ * ~~~~~~~~~~
+ */
+using RedisExecutor = std::function<void(std::coroutine_handle<>)>;
+
+/**
+ * Awaitable result of an asynchronous RedisClient command.
+ *
+ * The command is sent and committed when the awaiting coroutine suspends, and
+ * the coroutine resumes with the decoded result when the reply arrives.
+ * Errors are rethrown from the co_await expression.
+ */
+template <typename T>
+class RedisAwaitable {
+ public:
+  using ValueCallback = std::function<void(T&&)>;
+  using ErrorCallback = std::function<void(const std::string&)>;
+
+  /**
+   * Function that queues the command with the given callbacks.
+   */
+  using Initiator = std::function<void(ValueCallback&&, ErrorCallback&&)>;
+
+  RedisAwaitable(RedisClient& redis_client, Initiator&& initiate,
+                 const RedisExecutor& executor)
+      : redis_client_(redis_client),
+        initiate_(std::move(initiate)),
+        executor_(executor) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    // The coroutine may resume and destroy this awaitable as soon as the
+    // command is queued, so only locals may be accessed afterwards.
+    RedisClient& redis_client = redis_client_;
+    Initiator initiate = std::move(initiate_);
+    initiate(
+        [this, handle, executor = executor_](T&& value) {
+          value_ = std::move(value);
+          Resume(handle, executor);
+        },
+        [this, handle, executor = executor_](const std::string& error) {
+          error_ = std::make_exception_ptr(std::runtime_error(error));
+          Resume(handle, executor);
+        });
+    redis_client.commit();
+  }
+
+  T await_resume() {
+    if (error_) std::rethrow_exception(error_);
+    return std::move(*value_);
+  }
+
+ private:
+  static void Resume(std::coroutine_handle<> handle,
+                     const RedisExecutor& executor) {
+    if (executor) {
+      executor(handle);
+    } else {
+      handle.resume();
+    }
+  }
+
+  RedisClient& redis_client_;
+  Initiator initiate_;
+  RedisExecutor executor_;
+  std::optional<T> value_;
+  std::exception_ptr error_;
+};
+
+/**
+ * Awaitable Redis GET command.
+ *
+ * __Example__
+ * ~~~~~~~~~~ {.cc}
+ * ctrl_utils::RedisTask<void> Monitor(ctrl_utils::RedisClient& redis) {
+ *   const Eigen::VectorXd q =
+ *       co_await ctrl_utils::AwaitGet<Eigen::VectorXd>(redis, "robot::q");
+ *   co_await ctrl_utils::AwaitSet(redis, "robot::q_des", q);
+ * }
+ * ~~~~~~~~~~
+ */
+template <typename T>
+RedisAwaitable<T> AwaitGet(RedisClient& redis_client, const std::string& key,
+                           const RedisExecutor& executor = {}) {
+  return RedisAwaitable<T>(
+      redis_client,
+      [&redis_client, key](std::function<void(T&&)>&& reply_callback,
+                           std::function<void(const std::string&)>&&
+                               error_callback) {
+        redis_client.get<T>(key, reply_callback, error_callback);
+      },
+      executor);
+}
+
+/**
+ * Awaitable Redis SET command.
+ *
+ * Error replies are rethrown from the co_await expression.
+ */
+template <typename T>
+RedisAwaitable<cpp_redis::reply> AwaitSet(RedisClient& redis_client,
+                                          const std::string& key,
+                                          const T& value,
+                                          const RedisExecutor& executor = {}) {
+  return RedisAwaitable<cpp_redis::reply>(
+      redis_client,
+      [&redis_client, key, value](
+          std::function<void(cpp_redis::reply&&)>&& reply_callback,
+          std::function<void(const std::string&)>&& error_callback) {
+        redis_client.set(
+            key, value,
+            [reply_callback = std::move(reply_callback),
+             error_callback = std::move(error_callback)](
+                cpp_redis::reply& reply) {
+              if (reply.is_error()) {
+                error_callback("RedisClient::set(): " + reply.as_string());
+                return;
+              }
+              reply_callback(std::move(reply));
+            });
+      },
+      executor);
+}
+
+/**
+ * Awaitable Redis MGET command for homogeneous value types.
+ */
+template <typename T>
+RedisAwaitable<std::vector<T>> AwaitMget(RedisClient& redis_client,
+                                         const std::vector<std::string>& keys,
+                                         const RedisExecutor& executor = {}) {
+  return RedisAwaitable<std::vector<T>>(
+      redis_client,
+      [&redis_client, keys](
+          std::function<void(std::vector<T>&&)>&& reply_callback,
+          std::function<void(const std::string&)>&& error_callback) {
+        redis_client.mget<T>(keys, reply_callback, error_callback);
+      },
+      executor);
+}
+
+/**
+ * Awaitable Redis PUBLISH command.
+ *
+ * @return Number of subscribers that received the message.
+ */
+template <typename T>
+RedisAwaitable<cpp_redis::reply> AwaitPublish(
+    RedisClient& redis_client, const std::string& key, const T& value,
+    const RedisExecutor& executor = {}) {
+  return RedisAwaitable<cpp_redis::reply>(
+      redis_client,
+      [&redis_client, key, value](
+          std::function<void(cpp_redis::reply&&)>&& reply_callback,
+          std::function<void(const std::string&)>&& error_callback) {
+        redis_client.publish(
+            key, value,
+            [reply_callback = std::move(reply_callback),
+             error_callback = std::move(error_callback)](
+                cpp_redis::reply& reply) {
+              if (reply.is_error()) {
+                error_callback("RedisClient::publish(): " + reply.as_string());
+                return;
+              }
+              reply_callback(std::move(reply));
+            });
+      },
+      executor);
+}
+
+/**
+ * Awaitable request/response over Redis pub/sub.
+ *
+ * @see RedisClient::request()
+ */
+template <typename TSub, typename TPub>
+RedisAwaitable<TSub> AwaitRequest(RedisClient& redis_client,
+                                  const std::string& key_pub,
+                                  const TPub& value_pub,
+                                  const std::string& key_sub,
+                                  const RedisExecutor& executor = {}) {
+  return RedisAwaitable<TSub>(
+      redis_client,
+      [&redis_client, key_pub, value_pub, key_sub](
+          std::function<void(TSub&&)>&& reply_callback,
+          std::function<void(const std::string&)>&& error_callback) {
+        redis_client.request<TSub>(key_pub, value_pub, key_sub,
+                                   std::move(reply_callback),
+                                   std::move(error_callback));
+      },
+      executor);
+}
+
+/**
+ * Awaitable Redis SCAN command that collects all keys.
+ */
+inline RedisAwaitable<std::unordered_set<std::string>> AwaitScan(
+    RedisClient& redis_client, const std::string& pattern,
+    const RedisExecutor& executor = {}) {
+  return RedisAwaitable<std::unordered_set<std::string>>(
+      redis_client,
+      [&redis_client, pattern](
+          std::function<void(std::unordered_set<std::string>&&)>&&
+              reply_callback,
+          std::function<void(const std::string&)>&& error_callback) {
+        redis_client.scan(pattern, std::move(reply_callback),
+                          std::move(error_callback));
+      },
+      executor);
+}
+
+/**
+ * Coroutine return type for code that awaits Redis commands.
+ *
+ * The coroutine starts running immediately. Its result can be awaited from
+ * another coroutine with co_await or waited for from a normal thread with
+ * get(). A task destroyed before its coroutine finishes detaches from it, and
+ * the coroutine frame is destroyed when it finishes.
+ *
+ * __Example__
+ * ~~~~~~~~~~ {.cc}
+ * ctrl_utils::RedisTask<double> Sum(ctrl_utils::RedisClient& redis) {
+ *   const std::vector<std::string> keys = {"a", "b"};
+ *   const std::vector<double> values =
+ *       co_await ctrl_utils::AwaitMget<double>(redis, keys);
+ *   co_return values[0] + values[1];
+ * }
+ *
+ * std::cout << Sum(redis_client).get() << std::endl;
+ * ~~~~~~~~~~
+ */
+template <typename T = void>
+class RedisTask;
+
+namespace redis_coroutine_internal {
+
+/**
+ * Completion state shared between a task and its coroutine.
+ *
+ * The continuation slot holds either nullptr (running), the handle of an
+ * awaiting coroutine, or one of the kDone/kDetached markers.
+ */
+class TaskPromiseBase {
+ public:
+  std::suspend_never initial_suspend() noexcept { return {}; }
+
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept {
+      // The owner may destroy the frame as soon as it sees kDone, so keep
+      // the state alive for the notification.
+      const std::shared_ptr<std::atomic<void*>> state = handle.promise().state_;
+      void* prev_state = state->exchange(kDone());
+      state->notify_all();
+      if (prev_state == kDetached()) {
+        handle.destroy();
+      } else if (prev_state != nullptr) {
+        return std::coroutine_handle<>::from_address(prev_state);
+      }
+      return std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() { error_ = std::current_exception(); }
+
+  /**
+   * Registers the awaiting coroutine. Returns false if the task has already
+   * finished.
+   */
+  bool SetContinuation(std::coroutine_handle<> continuation) {
+    void* expected = nullptr;
+    return state_->compare_exchange_strong(expected, continuation.address());
+  }
+
+  /**
+   * Detaches the task. Returns true if the coroutine has already finished and
+   * should be destroyed by the caller.
+   */
+  bool Detach() { return state_->exchange(kDetached()) == kDone(); }
+
+  bool is_done() const { return state_->load() == kDone(); }
+
+  void Wait() const {
+    void* state = state_->load();
+    while (state != kDone()) {
+      state_->wait(state);
+      state = state_->load();
+    }
+  }
+
+ protected:
+  static void* kDone() {
+    static char marker;
+    return &marker;
+  }
+
+  static void* kDetached() {
+    static char marker;
+    return &marker;
+  }
+
+  std::shared_ptr<std::atomic<void*>> state_ =
+      std::make_shared<std::atomic<void*>>(nullptr);
+  std::exception_ptr error_;
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+ public:
+  RedisTask<T> get_return_object();
+
+  void return_value(T value) { value_ = std::move(value); }
+
+  T Result() {
+    if (error_) std::rethrow_exception(error_);
+    return std::move(*value_);
+  }
+
+ private:
+  std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+ public:
+  RedisTask<void> get_return_object();
+
+  void return_void() {}
+
+  void Result() {
+    if (error_) std::rethrow_exception(error_);
+  }
+};
+
+}  // namespace redis_coroutine_internal
+
+template <typename T>
+class RedisTask {
+ public:
+  using promise_type = redis_coroutine_internal::TaskPromise<T>;
+
+  explicit RedisTask(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  RedisTask(RedisTask&& other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {}
+
+  RedisTask& operator=(RedisTask&& other) noexcept {
+    if (this != &other) {
+      Release();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+
+  RedisTask(const RedisTask&) = delete;
+  RedisTask& operator=(const RedisTask&) = delete;
+
+  ~RedisTask() { Release(); }
+
+  /**
+   * @return Whether the coroutine has finished.
+   */
+  bool is_done() const { return handle_.promise().is_done(); }
+
+  /**
+   * Blocks until the coroutine finishes and returns its result.
+   */
+  T get() {
+    handle_.promise().Wait();
+    return handle_.promise().Result();
+  }
+
+  bool await_ready() const { return is_done(); }
+
+  bool await_suspend(std::coroutine_handle<> continuation) {
+    return handle_.promise().SetContinuation(continuation);
+  }
+
+  T await_resume() { return handle_.promise().Result(); }
+
+ private:
+  void Release() {
+    if (handle_ && handle_.promise().Detach()) handle_.destroy();
+    handle_ = nullptr;
+  }
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace redis_coroutine_internal {
+
+template <typename T>
+RedisTask<T> TaskPromise<T>::get_return_object() {
+  return RedisTask<T>(
+      std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline RedisTask<void> TaskPromise<void>::get_return_object() {
+  return RedisTask<void>(
+      std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+}  // namespace redis_coroutine_internal
+
+}  // namespace ctrl_utils
+
+#endif  // __cplusplus >= 202002L && __has_include(<coroutine>)
+
+#endif  // CTRL_UTILS_REDIS_COROUTINE_H_
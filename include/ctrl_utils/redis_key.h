@@ -0,0 +1,179 @@
+/**
+ * redis_key.h
+ *
+ * Copyright 2026. All Rights Reserved.
+ *
+ * Created: October 17, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef CTRL_UTILS_REDIS_KEY_H_
+#define CTRL_UTILS_REDIS_KEY_H_
+
+#include <stdexcept>  // std::runtime_error
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+#include "ctrl_utils/redis_client.h"
+
+namespace ctrl_utils {
+
+/**
+ * Handle to a Redis key that is read and written repeatedly.
+ *
+ * The GET and SET commands are built once and reused, replies are decoded in
+ * place into a buffer owned by the handle, and the reply callbacks capture no
+ * heap state. A control loop reading the same keys every cycle therefore
+ * avoids the per-call command, key, and value allocations of
+ * RedisClient::get().
+ *
+ * The handle must outlive its pending commands, and one handle should not be
+ * used from multiple threads at once.
+ *
+ * __Example__
+ * ~~~~~~~~~~ {.cc}
+ * ctrl_utils::RedisKey<Eigen::VectorXd> q(redis_client, "robot::q");
+ * ctrl_utils::RedisKey<Eigen::VectorXd> tau(redis_client, "robot::tau");
+ * while (true) {
+ *   q.Get();
+ *   redis_client.sync_commit();
+ *   tau.Set(ComputeTorques(q.value()));
+ *   redis_client.commit();
+ * }
+ * ~~~~~~~~~~
+ */
+template <typename T>
+class RedisKey {
+ public:
+  /**
+   * Constructs a handle for the key.
+   *
+   * @param redis_client Connected Redis client.
+   * @param key Redis key.
+   */
+  RedisKey(RedisClient& redis_client, const std::string& key)
+      : redis_client_(redis_client),
+        get_command_{"GET", key},
+        set_command_{"SET", key, std::string()} {}
+
+  RedisKey(const RedisKey&) = delete;
+  RedisKey& operator=(const RedisKey&) = delete;
+
+  /**
+   * @return Redis key.
+   */
+  const std::string& key() const { return get_command_[1]; }
+
+  /**
+   * Value from the last successful Get().
+   *
+   * The value is updated when the reply arrives, so it should only be read
+   * after RedisClient::sync_commit() returns.
+   */
+  const T& value() const { return value_; }
+
+  /**
+   * @return Error from the last Get(), or an empty string if it succeeded.
+   */
+  const std::string& error() const { return error_; }
+
+  /**
+   * Queues a GET that decodes the reply into value().
+   *
+   * If the key has a value buffered by RedisClient::enable_write_back() or is
+   * cached by RedisClient::enable_cache(), value() is updated immediately
+   * without contacting the server. On failure, value() is left unchanged and
+   * error() describes the failure.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   */
+  RedisKey& Get() {
+    if (redis_client_.is_write_back_enabled_) {
+      try {
+        if (redis_client_.GetWriteBack(key(), value_)) {
+          error_.clear();
+          return *this;
+        }
+      } catch (const std::exception& e) {
+        error_ = "RedisKey::Get(): Exception thrown on key: " + key() +
+                 "\n\t" + e.what();
+        return *this;
+      }
+    }
+
+    uint64_t cache_epoch = 0;
+    if (redis_client_.is_cache_enabled_ &&
+        redis_client_.GetCached(key(), value_, cache_epoch)) {
+      error_.clear();
+      return *this;
+    }
+
+    redis_client_.Send(get_command_, [this,
+                                      cache_epoch](cpp_redis::reply& reply) {
+      OnGetReply(reply, cache_epoch);
+    });
+    return *this;
+  }
+
+  /**
+   * Gets the value and waits for the reply.
+   *
+   * This calls RedisClient::sync_commit(), which also waits for all other
+   * pending commands.
+   *
+   * @return Reference to value().
+   */
+  const T& SyncGet() {
+    Get();
+    redis_client_.sync_commit();
+    if (!error_.empty()) throw std::runtime_error(error_);
+    return value_;
+  }
+
+  /**
+   * Queues a SET with the value.
+   *
+   * The value is encoded into the reused command buffer with the codec of the
+   * key, including shared memory, compression, and write-back if enabled.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   */
+  RedisKey& Set(const T& value) {
+    std::string& str = set_command_[2];
+    redis_client_.Encode(key(), value, str);
+    redis_client_.InvalidateCache(key());
+    if (redis_client_.WriteBack(key(), str, nullptr)) return *this;
+    redis_client_.WriteSharedMemory(key(), str);
+    redis_client_.Send(set_command_, [](cpp_redis::reply&) {});
+    return *this;
+  }
+
+ private:
+  void OnGetReply(cpp_redis::reply& reply, uint64_t cache_epoch) {
+    if (!reply.is_string()) {
+      error_ = "RedisKey::Get(): Failed to get string value from key: " +
+               key() + ".";
+      return;
+    }
+    try {
+      RedisClient::Decode(reply.as_string(), value_);
+      error_.clear();
+      if (cache_epoch != 0) {
+        redis_client_.SetCached(key(), value_, cache_epoch);
+      }
+    } catch (const std::exception& e) {
+      error_ = "RedisKey::Get(): Exception thrown on key: " + key() + "\n\t" +
+               e.what();
+    }
+  }
+
+  RedisClient& redis_client_;
+  std::vector<std::string> get_command_;
+  std::vector<std::string> set_command_;
+  T value_ = T();
+  std::string error_;
+};
+
+}  // namespace ctrl_utils
+
+#endif  // CTRL_UTILS_REDIS_KEY_H_
@@ -0,0 +1,686 @@
+/**
+ * redis_server.h
+ *
+ * Copyright 2026. All Rights Reserved.
+ *
+ * Created: October 17, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef CTRL_UTILS_REDIS_SERVER_H_
+#define CTRL_UTILS_REDIS_SERVER_H_
+
+#include <arpa/inet.h>    // htonl, htons, ntohs
+#include <netinet/in.h>   // sockaddr_in
+#include <netinet/tcp.h>  // TCP_NODELAY
+#include <sys/socket.h>   // accept, bind, listen, recv, send, shutdown
+#include <unistd.h>       // close
+
+#include <algorithm>      // std::find, std::find_if, std::sort, std::transform
+#include <atomic>         // std::atomic
+#include <cctype>         // std::tolower, std::toupper
+#include <cerrno>         // errno
+#include <chrono>         // std::chrono
+#include <cstring>        // std::strerror
+#include <functional>     // std::hash
+#include <memory>         // std::make_shared, std::shared_ptr
+#include <mutex>          // std::mutex, std::unique_lock
+#include <stdexcept>      // std::runtime_error
+#include <string>         // std::string
+#include <thread>         // std::thread
+#include <unordered_map>  // std::unordered_map
+#include <unordered_set>  // std::unordered_set
+#include <utility>        // std::move, std::pair
+#include <vector>         // std::vector
+
+#include "ctrl_utils/string.h"
+
+namespace ctrl_utils {
+
+/**
+ * Minimal in-process Redis server for deterministic benchmarks and tests.
+ *
+ * The server speaks RESP on a local TCP port and supports the commands used by
+ * RedisClient: GET, SET, MGET, MSET, DEL, EXISTS, HGET, HSET, HMSET, HMGET,
+ * HGETALL, PUBLISH, SUBSCRIBE, PSUBSCRIBE, UNSUBSCRIBE, PUNSUBSCRIBE, SCAN,
+ * KEYS, FLUSHALL, PING, AUTH, SELECT and CONFIG. Keys are not persisted and
+ * never expire.
+ *
+ * SCAN supports the MATCH, COUNT and TYPE options. Keys are visited in hash
+ * order, so like Redis, a key present for the whole scan is returned at least
+ * once even if other keys are added or removed.
+ *
+ * Replies to the commands received in one read are held back by the injected
+ * latency, which models a network round trip. Pipelined commands therefore
+ * share one delay, as they would with a remote server. Published messages
+ * are delivered to subscribers immediately.
+ *
+ * Each connection is served by its own thread, which is joined after the
+ * connection closes.
+ *
+ * __Example__
+ * ~~~~~~~~~~ {.cc}
+ * ctrl_utils::RedisServer redis_server(0, std::chrono::microseconds(200));
+ *
+ * ctrl_utils::RedisClient redis_client;
+ * redis_client.connect("127.0.0.1", redis_server.port());
+ * redis_client.sync_set("key", 1.0);
+ * ~~~~~~~~~~
+ */
+class RedisServer {
+ public:
+  /**
+   * Starts the server on 127.0.0.1.
+   *
+   * @param port TCP port, or 0 to pick a free port (see port()).
+   * @param latency Delay added before sending replies.
+   */
+  explicit RedisServer(
+      size_t port = 0,
+      std::chrono::microseconds latency = std::chrono::microseconds::zero());
+
+  /**
+   * Stops the server and closes all connections.
+   */
+  ~RedisServer() { Stop(); }
+
+  RedisServer(const RedisServer&) = delete;
+  RedisServer& operator=(const RedisServer&) = delete;
+
+  /**
+   * @return TCP port the server is listening on.
+   */
+  size_t port() const { return port_; }
+
+  /**
+   * @return Delay added before sending replies.
+   */
+  std::chrono::microseconds latency() const { return latency_; }
+
+  /**
+   * Sets the delay added before sending replies.
+   */
+  void set_latency(std::chrono::microseconds latency) { latency_ = latency; }
+
+  /**
+   * @return Number of commands executed since the server started.
+   */
+  size_t num_commands() const { return num_commands_; }
+
+  /**
+   * Stops accepting connections and closes all open connections.
+   */
+  void Stop();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Connection {
+    explicit Connection(int fd) : fd(fd) {}
+
+    /**
+     * Sends the full buffer. Thread safe.
+     */
+    void Write(const std::string& data);
+
+    const int fd;
+    std::mutex mtx_write;
+
+    // Guarded by mtx_connections_.
+    std::unordered_set<std::string> channels;
+    std::unordered_set<std::string> patterns;
+  };
+
+  /**
+   * Accepts connections until the server stops.
+   */
+  void Accept();
+
+  /**
+   * Reads, executes and replies to commands until the connection closes.
+   */
+  void Serve(std::shared_ptr<Connection> connection);
+
+  /**
+   * Parses one RESP array of bulk strings starting at idx.
+   *
+   * @return False if the buffer does not hold a complete command yet.
+   */
+  static bool ParseCommand(const std::string& buffer, size_t& idx,
+                           std::vector<std::string>& command);
+
+  /**
+   * Executes the command and appends the RESP reply.
+   */
+  void Execute(std::vector<std::string>& command, Connection& connection,
+               std::string& reply);
+
+  /**
+   * Executes SCAN. Must be called with mtx_data_ locked.
+   */
+  void Scan(const std::vector<std::string>& command, std::string& reply);
+
+  /**
+   * Sends the message to matching subscribers.
+   *
+   * @return Number of subscribers that received the message.
+   */
+  size_t Publish(const std::string& channel, const std::string& message);
+
+  /**
+   * Updates the subscriptions of the connection and appends the
+   * acknowledgments.
+   */
+  void Subscribe(const std::vector<std::string>& command,
+                 Connection& connection, std::string& reply);
+
+  static void AppendSimple(const std::string& str, std::string& reply) {
+    reply += "+" + str + "\r\n";
+  }
+
+  static void AppendError(const std::string& str, std::string& reply) {
+    reply += "-" + str + "\r\n";
+  }
+
+  static void AppendInteger(long long n, std::string& reply) {
+    reply += ":" + std::to_string(n) + "\r\n";
+  }
+
+  static void AppendBulk(const std::string& str, std::string& reply) {
+    reply += "$" + std::to_string(str.size()) + "\r\n";
+    reply += str;
+    reply += "\r\n";
+  }
+
+  static void AppendNull(std::string& reply) { reply += "$-1\r\n"; }
+
+  static void AppendArray(size_t size, std::string& reply) {
+    reply += "*" + std::to_string(size) + "\r\n";
+  }
+
+  int fd_listen_ = -1;
+  size_t port_ = 0;
+  std::atomic<std::chrono::microseconds> latency_;
+  std::atomic<size_t> num_commands_ = 0;
+  std::atomic<bool> is_running_ = true;
+
+  std::mutex mtx_data_;
+  std::unordered_map<std::string, std::string> strings_;
+  std::unordered_map<std::string, std::unordered_map<std::string, std::string>>
+      hashes_;
+
+  std::mutex mtx_connections_;
+  std::vector<std::shared_ptr<Connection>> connections_;
+  std::vector<std::thread> threads_;
+
+  /// Threads of closed connections, joined by the next Accept() or Stop().
+  std::vector<std::thread> finished_threads_;
+
+  std::thread thread_accept_;
+};
+
+////////////////////
+// Implementation //
+////////////////////
+
+inline RedisServer::RedisServer(size_t port,
+                                std::chrono::microseconds latency)
+    : latency_(latency) {
+  fd_listen_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd_listen_ < 0) {
+    throw std::runtime_error("RedisServer(): Failed to create socket (" +
+                             std::string(std::strerror(errno)) + ").");
+  }
+  const int kEnable = 1;
+  setsockopt(fd_listen_, SOL_SOCKET, SO_REUSEADDR, &kEnable, sizeof(kEnable));
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  socklen_t len_addr = sizeof(addr);
+  if (bind(fd_listen_, reinterpret_cast<sockaddr*>(&addr), len_addr) != 0 ||
+      listen(fd_listen_, SOMAXCONN) != 0 ||
+      getsockname(fd_listen_, reinterpret_cast<sockaddr*>(&addr),
+                  &len_addr) != 0) {
+    const std::string error = std::strerror(errno);
+    close(fd_listen_);
+    throw std::runtime_error("RedisServer(): Failed to listen on port " +
+                             std::to_string(port) + " (" + error + ").");
+  }
+  port_ = ntohs(addr.sin_port);
+
+  thread_accept_ = std::thread(&RedisServer::Accept, this);
+}
+
+inline void RedisServer::Stop() {
+  if (!is_running_.exchange(false)) return;
+
+  // Unblock accept() and recv().
+  shutdown(fd_listen_, SHUT_RDWR);
+  thread_accept_.join();
+  close(fd_listen_);
+
+  std::vector<std::thread> threads;
+  {
+    std::unique_lock<std::mutex> lock(mtx_connections_);
+    for (const std::shared_ptr<Connection>& connection : connections_) {
+      shutdown(connection->fd, SHUT_RDWR);
+    }
+    threads.swap(threads_);
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  // Join the threads that finished before their connections were swapped out.
+  std::unique_lock<std::mutex> lock(mtx_connections_);
+  threads.swap(finished_threads_);
+  lock.unlock();
+  for (std::thread& thread : threads) thread.join();
+}
+
+inline void RedisServer::Accept() {
+  while (is_running_) {
+    const int fd = accept(fd_listen_, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      break;
+    }
+    const int kEnable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &kEnable, sizeof(kEnable));
+
+    auto connection = std::make_shared<Connection>(fd);
+    std::vector<std::thread> finished_threads;
+    {
+      std::unique_lock<std::mutex> lock(mtx_connections_);
+      if (!is_running_) {
+        close(fd);
+        break;
+      }
+      connections_.push_back(connection);
+      threads_.emplace_back(&RedisServer::Serve, this, std::move(connection));
+      finished_threads.swap(finished_threads_);
+    }
+
+    // Reap the threads of closed connections.
+    for (std::thread& thread : finished_threads) thread.join();
+  }
+}
+
+inline void RedisServer::Serve(std::shared_ptr<Connection> connection) {
+  std::string buffer;
+  std::string reply;
+  std::vector<std::string> command;
+  std::vector<char> chunk(1 << 16);
+  while (is_running_) {
+    const ssize_t num_read =
+        recv(connection->fd, chunk.data(), chunk.size(), 0);
+    if (num_read <= 0) break;
+    const Clock::time_point t_recv = Clock::now();
+    buffer.append(chunk.data(), num_read);
+
+    size_t idx = 0;
+    reply.clear();
+    try {
+      while (ParseCommand(buffer, idx, command)) {
+        Execute(command, *connection, reply);
+      }
+    } catch (const std::exception& e) {
+      AppendError("ERR Protocol error: " + std::string(e.what()), reply);
+      connection->Write(reply);
+      break;
+    }
+    buffer.erase(0, idx);
+    if (reply.empty()) continue;
+
+    std::this_thread::sleep_until(t_recv + latency_.load());
+    connection->Write(reply);
+  }
+
+  std::unique_lock<std::mutex> lock(mtx_connections_);
+  connections_.erase(
+      std::find(connections_.begin(), connections_.end(), connection));
+  close(connection->fd);
+
+  // Hand this thread over to be joined. Stop() may have taken it already.
+  const auto it_thread =
+      std::find_if(threads_.begin(), threads_.end(), [](const std::thread& t) {
+        return t.get_id() == std::this_thread::get_id();
+      });
+  if (it_thread != threads_.end()) {
+    finished_threads_.push_back(std::move(*it_thread));
+    threads_.erase(it_thread);
+  }
+}
+
+inline void RedisServer::Connection::Write(const std::string& data) {
+  std::unique_lock<std::mutex> lock(mtx_write);
+  for (size_t idx = 0; idx < data.size();) {
+    const ssize_t num_sent =
+        send(fd, data.data() + idx, data.size() - idx, MSG_NOSIGNAL);
+    if (num_sent <= 0) return;
+    idx += num_sent;
+  }
+}
+
+inline bool RedisServer::ParseCommand(const std::string& buffer, size_t& idx,
+                                      std::vector<std::string>& command) {
+  // Reads "<prefix><number>\r\n" at i.
+  auto ParseHeader = [&buffer](char prefix, size_t& i, size_t& n) {
+    if (i >= buffer.size()) return false;
+    if (buffer[i] != prefix) {
+      throw std::runtime_error(std::string("expected '") + prefix + "'");
+    }
+    const size_t idx_end = buffer.find("\r\n", i);
+    if (idx_end == std::string::npos) return false;
+    n = std::stoul(buffer.substr(i + 1, idx_end - i - 1));
+    i = idx_end + 2;
+    return true;
+  };
+
+  size_t i = idx;
+  size_t num_args;
+  if (!ParseHeader('*', i, num_args)) return false;
+
+  command.resize(num_args);
+  for (std::string& arg : command) {
+    size_t len;
+    if (!ParseHeader('$', i, len)) return false;
+    if (buffer.size() < i + len + 2) return false;
+    arg.assign(buffer, i, len);
+    i += len + 2;
+  }
+  idx = i;
+  return true;
+}
+
+inline void RedisServer::Execute(std::vector<std::string>& command,
+                                 Connection& connection, std::string& reply) {
+  if (command.empty()) return;
+  ++num_commands_;
+
+  std::string& name = command[0];
+  std::transform(name.begin(), name.end(), name.begin(),
+                 [](unsigned char c) { return std::toupper(c); });
+  const size_t num_args = command.size() - 1;
+  auto WrongArgs = [&name, &reply]() {
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    AppendError("ERR wrong number of arguments for '" + name + "' command",
+                reply);
+  };
+  static const std::string kWrongType =
+      "WRONGTYPE Operation against a key holding the wrong kind of value";
+
+  if (name == "PING") {
+    if (num_args == 0) {
+      AppendSimple("PONG", reply);
+    } else {
+      AppendBulk(command[1], reply);
+    }
+  } else if (name == "AUTH" || name == "SELECT") {
+    AppendSimple("OK", reply);
+  } else if (name == "CONFIG") {
+    if (num_args >= 1 && command[1] == "SET") {
+      AppendSimple("OK", reply);
+    } else {
+      AppendArray(0, reply);
+    }
+  } else if (name == "PUBLISH") {
+    if (num_args != 2) return WrongArgs();
+    AppendInteger(Publish(command[1], command[2]), reply);
+  } else if (name == "SUBSCRIBE" || name == "PSUBSCRIBE" ||
+             name == "UNSUBSCRIBE" || name == "PUNSUBSCRIBE") {
+    Subscribe(command, connection, reply);
+  } else {
+    std::unique_lock<std::mutex> lock(mtx_data_);
+    if (name == "GET") {
+      if (num_args != 1) return WrongArgs();
+      const auto it = strings_.find(command[1]);
+      if (it != strings_.end()) {
+        AppendBulk(it->second, reply);
+      } else if (hashes_.count(command[1]) > 0) {
+        AppendError(kWrongType, reply);
+      } else {
+        AppendNull(reply);
+      }
+    } else if (name == "SET") {
+      if (num_args < 2) return WrongArgs();
+      hashes_.erase(command[1]);
+      strings_[command[1]] = std::move(command[2]);
+      AppendSimple("OK", reply);
+    } else if (name == "MGET") {
+      if (num_args < 1) return WrongArgs();
+      AppendArray(num_args, reply);
+      for (size_t i = 1; i <= num_args; i++) {
+        const auto it = strings_.find(command[i]);
+        if (it == strings_.end()) {
+          AppendNull(reply);
+        } else {
+          AppendBulk(it->second, reply);
+        }
+      }
+    } else if (name == "MSET") {
+      if (num_args == 0 || num_args % 2 != 0) return WrongArgs();
+      for (size_t i = 1; i < command.size(); i += 2) {
+        hashes_.erase(command[i]);
+        strings_[command[i]] = std::move(command[i + 1]);
+      }
+      AppendSimple("OK", reply);
+    } else if (name == "DEL" || name == "EXISTS") {
+      if (num_args < 1) return WrongArgs();
+      long long num_keys = 0;
+      for (size_t i = 1; i <= num_args; i++) {
+        if (name == "DEL") {
+          num_keys += strings_.erase(command[i]) + hashes_.erase(command[i]);
+        } else {
+          num_keys += strings_.count(command[i]) + hashes_.count(command[i]);
+        }
+      }
+      AppendInteger(num_keys, reply);
+    } else if (name == "HSET" || name == "HMSET") {
+      if (num_args < 3 || num_args % 2 != 1) return WrongArgs();
+      if (strings_.count(command[1]) > 0) return AppendError(kWrongType, reply);
+      std::unordered_map<std::string, std::string>& hash = hashes_[command[1]];
+      long long num_new = 0;
+      for (size_t i = 2; i < command.size(); i += 2) {
+        num_new += hash.count(command[i]) == 0;
+        hash[command[i]] = std::move(command[i + 1]);
+      }
+      if (name == "HSET") {
+        AppendInteger(num_new, reply);
+      } else {
+        AppendSimple("OK", reply);
+      }
+    } else if (name == "HGET" || name == "HMGET") {
+      if (num_args < 2 || (name == "HGET" && num_args != 2)) {
+        return WrongArgs();
+      }
+      if (strings_.count(command[1]) > 0) return AppendError(kWrongType, reply);
+      const auto it_hash = hashes_.find(command[1]);
+      if (name == "HMGET") AppendArray(num_args - 1, reply);
+      for (size_t i = 2; i <= num_args; i++) {
+        if (it_hash == hashes_.end()) {
+          AppendNull(reply);
+          continue;
+        }
+        const auto it = it_hash->second.find(command[i]);
+        if (it == it_hash->second.end()) {
+          AppendNull(reply);
+        } else {
+          AppendBulk(it->second, reply);
+        }
+      }
+    } else if (name == "HGETALL") {
+      if (num_args != 1) return WrongArgs();
+      if (strings_.count(command[1]) > 0) return AppendError(kWrongType, reply);
+      const auto it_hash = hashes_.find(command[1]);
+      if (it_hash == hashes_.end()) return AppendArray(0, reply);
+      AppendArray(2 * it_hash->second.size(), reply);
+      for (const auto& field_val : it_hash->second) {
+        AppendBulk(field_val.first, reply);
+        AppendBulk(field_val.second, reply);
+      }
+    } else if (name == "SCAN") {
+      if (num_args < 1) return WrongArgs();
+      Scan(command, reply);
+    } else if (name == "KEYS") {
+      if (num_args != 1) return WrongArgs();
+      const std::string& pattern = command[1];
+      std::vector<const std::string*> keys;
+      for (const auto& key_val : strings_) {
+        if (MatchGlob(pattern, key_val.first)) keys.push_back(&key_val.first);
+      }
+      for (const auto& key_val : hashes_) {
+        if (MatchGlob(pattern, key_val.first)) keys.push_back(&key_val.first);
+      }
+      AppendArray(keys.size(), reply);
+      for (const std::string* key : keys) AppendBulk(*key, reply);
+    } else if (name == "FLUSHALL" || name == "FLUSHDB") {
+      strings_.clear();
+      hashes_.clear();
+      AppendSimple("OK", reply);
+    } else {
+      std::transform(name.begin(), name.end(), name.begin(),
+                     [](unsigned char c) { return std::tolower(c); });
+      AppendError("ERR unknown command '" + name + "'", reply);
+    }
+  }
+}
+
+inline void RedisServer::Scan(const std::vector<std::string>& command,
+                              std::string& reply) {
+  static const std::string kSyntaxError = "ERR syntax error";
+  size_t cursor;
+  try {
+    size_t idx_end;
+    cursor = std::stoull(command[1], &idx_end);
+    if (idx_end != command[1].size()) throw std::invalid_argument("cursor");
+  } catch (const std::exception&) {
+    return AppendError("ERR invalid cursor", reply);
+  }
+
+  std::string pattern = "*";
+  size_t count = 10;
+  std::string type;
+  for (size_t i = 2; i < command.size(); i += 2) {
+    if (i + 1 >= command.size()) return AppendError(kSyntaxError, reply);
+    std::string option = command[i];
+    std::transform(option.begin(), option.end(), option.begin(),
+                   [](unsigned char c) { return std::toupper(c); });
+    if (option == "MATCH") {
+      pattern = command[i + 1];
+    } else if (option == "COUNT") {
+      try {
+        count = std::stoul(command[i + 1]);
+      } catch (const std::exception&) {
+        count = 0;
+      }
+      if (count == 0) return AppendError(kSyntaxError, reply);
+    } else if (option == "TYPE") {
+      type = command[i + 1];
+      std::transform(type.begin(), type.end(), type.begin(),
+                     [](unsigned char c) { return std::tolower(c); });
+    } else {
+      return AppendError(kSyntaxError, reply);
+    }
+  }
+
+  // Visit keys in hash order and return the hash of the next key as the
+  // cursor, so that adding or removing keys does not skip the remaining ones.
+  std::vector<std::pair<size_t, const std::string*>> keys;
+  auto AddKeys = [&](const auto& map, const std::string& key_type) {
+    if (!type.empty() && type != key_type) return;
+    for (const auto& key_val : map) {
+      const size_t hash = std::hash<std::string>()(key_val.first);
+      if (hash < cursor || !MatchGlob(pattern, key_val.first)) continue;
+      keys.emplace_back(hash, &key_val.first);
+    }
+  };
+  AddKeys(strings_, "string");
+  AddKeys(hashes_, "hash");
+  std::sort(keys.begin(), keys.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  // Keys with the same hash are returned together.
+  size_t num_keys = count < keys.size() ? count : keys.size();
+  while (num_keys < keys.size() &&
+         keys[num_keys].first == keys[num_keys - 1].first) {
+    ++num_keys;
+  }
+  const size_t next_cursor = num_keys < keys.size() ? keys[num_keys].first : 0;
+
+  AppendArray(2, reply);
+  AppendBulk(std::to_string(next_cursor), reply);
+  AppendArray(num_keys, reply);
+  for (size_t i = 0; i < num_keys; i++) AppendBulk(*keys[i].second, reply);
+}
+
+inline size_t RedisServer::Publish(const std::string& channel,
+                                   const std::string& message) {
+  std::vector<std::pair<std::shared_ptr<Connection>, std::string>> receivers;
+  {
+    std::unique_lock<std::mutex> lock(mtx_connections_);
+    for (const std::shared_ptr<Connection>& connection : connections_) {
+      if (connection->channels.count(channel) > 0) {
+        std::string reply;
+        AppendArray(3, reply);
+        AppendBulk("message", reply);
+        AppendBulk(channel, reply);
+        AppendBulk(message, reply);
+        receivers.emplace_back(connection, std::move(reply));
+      }
+      for (const std::string& pattern : connection->patterns) {
+        if (!MatchGlob(pattern, channel)) continue;
+        std::string reply;
+        AppendArray(4, reply);
+        AppendBulk("pmessage", reply);
+        AppendBulk(pattern, reply);
+        AppendBulk(channel, reply);
+        AppendBulk(message, reply);
+        receivers.emplace_back(connection, std::move(reply));
+      }
+    }
+  }
+
+  // Write outside the lock so that a slow subscriber cannot block others from
+  // subscribing.
+  for (const auto& receiver : receivers) receiver.first->Write(receiver.second);
+  return receivers.size();
+}
+
+inline void RedisServer::Subscribe(const std::vector<std::string>& command,
+                                   Connection& connection,
+                                   std::string& reply) {
+  const std::string& name = command[0];
+  const bool is_pattern = name[0] == 'P';
+  const bool is_subscribe = name.find("UNSUBSCRIBE") == std::string::npos;
+
+  std::string kind = name;
+  std::transform(kind.begin(), kind.end(), kind.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+
+  std::unique_lock<std::mutex> lock(mtx_connections_);
+  std::unordered_set<std::string>& subscriptions =
+      is_pattern ? connection.patterns : connection.channels;
+
+  std::vector<std::string> channels(command.begin() + 1, command.end());
+  if (!is_subscribe && channels.empty()) {
+    channels.assign(subscriptions.begin(), subscriptions.end());
+  }
+  for (const std::string& channel : channels) {
+    if (is_subscribe) {
+      subscriptions.insert(channel);
+    } else {
+      subscriptions.erase(channel);
+    }
+    AppendArray(3, reply);
+    AppendBulk(kind, reply);
+    AppendBulk(channel, reply);
+    AppendInteger(connection.channels.size() + connection.patterns.size(),
+                  reply);
+  }
+}
+
+}  // namespace ctrl_utils
+
+#endif  // CTRL_UTILS_REDIS_SERVER_H_
@@ -0,0 +1,185 @@
+/**
+ * redis_stats.h
+ *
+ * Copyright 2026. All Rights Reserved.
+ *
+ * Created: October 17, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef CTRL_UTILS_REDIS_STATS_H_
+#define CTRL_UTILS_REDIS_STATS_H_
+
+#include <algorithm>  // std::max, std::min
+#include <array>      // std::array
+#include <chrono>     // std::chrono
+#include <cstdint>    // uint64_t
+#include <map>        // std::map
+#include <string>     // std::string
+
+#if __has_include(<nlohmann/json.hpp>)
+#include <nlohmann/json.hpp>
+#endif  // __has_include(<nlohmann/json.hpp>)
+
+namespace ctrl_utils {
+
+/**
+ * Histogram of durations with power-of-two nanosecond buckets.
+ *
+ * Adding a sample is a handful of integer operations, and percentiles are
+ * accurate to within a factor of two.
+ */
+class LatencyHistogram {
+ public:
+  using Duration = std::chrono::nanoseconds;
+
+  static constexpr size_t kNumBuckets = 48;
+
+  /**
+   * Adds a sample. Negative durations are counted as zero.
+   */
+  void Add(Duration duration) {
+    const uint64_t ns = duration.count() > 0 ? duration.count() : 0;
+    size_t idx = 0;
+    for (uint64_t n = ns; n > 0 && idx + 1 < kNumBuckets; n >>= 1) ++idx;
+    ++buckets_[idx];
+
+    min_ = count_ == 0 ? ns : std::min(min_, ns);
+    max_ = std::max(max_, ns);
+    sum_ += ns;
+    ++count_;
+  }
+
+  /**
+   * @return Number of samples.
+   */
+  uint64_t count() const { return count_; }
+
+  /**
+   * @return Smallest sample, or zero if there are no samples.
+   */
+  Duration min() const { return Duration(min_); }
+
+  /**
+   * @return Largest sample, or zero if there are no samples.
+   */
+  Duration max() const { return Duration(max_); }
+
+  /**
+   * @return Mean of the samples, or zero if there are no samples.
+   */
+  Duration mean() const {
+    return Duration(count_ == 0 ? 0 : sum_ / count_);
+  }
+
+  /**
+   * Number of samples in a bucket. Bucket 0 holds zero durations, and bucket
+   * i > 0 holds durations in [2^(i-1), 2^i) ns.
+   */
+  uint64_t bucket(size_t idx) const { return buckets_[idx]; }
+
+  /**
+   * Estimates the duration below which the given fraction of samples fall.
+   *
+   * @param p Fraction between 0 and 1 (e.g. 0.99).
+   * @return Upper bound of the bucket containing the percentile, clamped to
+   *         the largest sample.
+   */
+  Duration Percentile(double p) const {
+    if (count_ == 0) return Duration(0);
+    const uint64_t rank = std::max<uint64_t>(1, p * count_ + 0.5);
+    uint64_t num_samples = 0;
+    for (size_t i = 0; i < kNumBuckets; i++) {
+      num_samples += buckets_[i];
+      if (num_samples >= rank) {
+        const uint64_t upper = i == 0 ? 0 : (uint64_t{1} << i) - 1;
+        return Duration(std::min(std::max(upper, min_), max_));
+      }
+    }
+    return max();
+  }
+
+ private:
+  std::array<uint64_t, kNumBuckets> buckets_ = {};
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = 0;
+  uint64_t max_ = 0;
+};
+
+/**
+ * Statistics for one Redis command type (e.g. "GET").
+ */
+struct RedisCommandStats {
+  /// Number of commands sent.
+  uint64_t num_commands = 0;
+
+  /// Number of error replies.
+  uint64_t num_errors = 0;
+
+  /// RESP-encoded bytes sent.
+  uint64_t num_bytes_out = 0;
+
+  /// RESP-encoded bytes received.
+  uint64_t num_bytes_in = 0;
+
+  /// Time from queueing the command until it is committed.
+  LatencyHistogram queue_latency;
+
+  /// Time from committing the command until its reply is received.
+  LatencyHistogram reply_latency;
+
+  /// Time spent in the reply callback, which includes decoding the value.
+  LatencyHistogram decode_latency;
+};
+
+/**
+ * Snapshot of RedisClient instrumentation.
+ */
+struct RedisStats {
+  /// Statistics by command type.
+  std::map<std::string, RedisCommandStats> commands;
+
+  /// Number of commands sent that are still waiting for a reply.
+  uint64_t num_in_flight = 0;
+
+  /// Largest number of commands waiting for a reply at once.
+  uint64_t max_in_flight = 0;
+};
+
+#if __has_include(<nlohmann/json.hpp>)
+
+/**
+ * Serializes the statistics to Json, with durations in nanoseconds.
+ */
+inline void to_json(nlohmann::json& json, const LatencyHistogram& histogram) {
+  json["count"] = histogram.count();
+  json["min_ns"] = histogram.min().count();
+  json["mean_ns"] = histogram.mean().count();
+  json["p50_ns"] = histogram.Percentile(0.5).count();
+  json["p90_ns"] = histogram.Percentile(0.9).count();
+  json["p99_ns"] = histogram.Percentile(0.99).count();
+  json["max_ns"] = histogram.max().count();
+}
+
+inline void to_json(nlohmann::json& json, const RedisCommandStats& stats) {
+  json["num_commands"] = stats.num_commands;
+  json["num_errors"] = stats.num_errors;
+  json["num_bytes_out"] = stats.num_bytes_out;
+  json["num_bytes_in"] = stats.num_bytes_in;
+  json["queue_latency"] = stats.queue_latency;
+  json["reply_latency"] = stats.reply_latency;
+  json["decode_latency"] = stats.decode_latency;
+}
+
+inline void to_json(nlohmann::json& json, const RedisStats& stats) {
+  json["commands"] = stats.commands;
+  json["num_in_flight"] = stats.num_in_flight;
+  json["max_in_flight"] = stats.max_in_flight;
+}
+
+#endif  // __has_include(<nlohmann/json.hpp>)
+
+}  // namespace ctrl_utils
+
+#endif  // CTRL_UTILS_REDIS_STATS_H_
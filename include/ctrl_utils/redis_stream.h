@@ -0,0 +1,181 @@
+/**
+ * redis_stream.h
+ *
+ * Copyright 2026. All Rights Reserved.
+ *
+ * Created: October 17, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef CTRL_UTILS_REDIS_STREAM_H_
+#define CTRL_UTILS_REDIS_STREAM_H_
+
+#include <chrono>   // std::chrono
+#include <future>   // std::future
+#include <string>   // std::string
+#include <utility>  // std::pair
+#include <vector>   // std::vector
+
+#include "ctrl_utils/redis_client.h"
+
+namespace ctrl_utils {
+
+/**
+ * Appends entries with many fields to a Redis stream.
+ *
+ * Fields are encoded as they are added, and each call to Append() sends a
+ * single XADD command with all of them. Entries are pipelined according to
+ * the client's pipeline policy, so a control loop can record its state every
+ * cycle without waiting for a round trip.
+ *
+ * __Example__
+ * ~~~~~~~~~~ {.cc}
+ * ctrl_utils::RedisStreamWriter log(redis_client, "robot::log", 100000);
+ * while (true) {
+ *   log.Add("q", q).Add("dq", dq).Add("tau", tau).Append();
+ *   redis_client.commit_and_sleep(timer);
+ * }
+ * ~~~~~~~~~~
+ */
+class RedisStreamWriter {
+ public:
+  /**
+   * Constructs a writer for the stream.
+   *
+   * @param redis_client Connected Redis client.
+   * @param key Redis stream key.
+   * @param max_len Approximate maximum length of the stream, or 0 for an
+   *                unbounded stream.
+   */
+  RedisStreamWriter(RedisClient& redis_client, const std::string& key,
+                    size_t max_len = 0)
+      : redis_client_(redis_client), key_(key), max_len_(max_len) {}
+
+  /**
+   * @return Redis stream key.
+   */
+  const std::string& key() const { return key_; }
+
+  /**
+   * Adds a field to the next entry.
+   *
+   * The value is encoded with the codec of the stream key.
+   */
+  template <typename T>
+  RedisStreamWriter& Add(const std::string& field, const T& value) {
+    field_vals_.emplace_back(field, redis_client_.Encode(key_, value));
+    return *this;
+  }
+
+  /**
+   * @return Number of fields added since the last append.
+   */
+  size_t num_fields() const { return field_vals_.size(); }
+
+  /**
+   * Appends the added fields as one stream entry.
+   *
+   * Commands are not sent until RedisClient::commit() is called.
+   *
+   * @return Future id of the new entry.
+   */
+  std::future<std::string> Append() {
+    std::future<std::string> fut_id =
+        redis_client_.xadd(key_, field_vals_, max_len_);
+    field_vals_.clear();
+    return fut_id;
+  }
+
+ private:
+  RedisClient& redis_client_;
+  std::string key_;
+  size_t max_len_;
+  std::vector<std::pair<std::string, std::string>> field_vals_;
+};
+
+/**
+ * Reads decoded batches of entries from a Redis stream.
+ *
+ * The reader remembers the id of the last entry it returned, so consecutive
+ * reads return each entry exactly once. Blocking reads hold the connection
+ * until new entries arrive, so the reader should be given its own
+ * RedisClient.
+ *
+ * __Example__
+ * ~~~~~~~~~~ {.cc}
+ * ctrl_utils::RedisStreamReader<Eigen::VectorXd> log(redis_client,
+ *                                                    "robot::log");
+ * while (true) {
+ *   for (const auto& entry : log.Read(1000, std::chrono::milliseconds(100))) {
+ *     std::cout << entry.id << ": " << entry.fields[0].second << std::endl;
+ *   }
+ * }
+ * ~~~~~~~~~~
+ */
+template <typename T>
+class RedisStreamReader {
+ public:
+  using Entry = RedisClient::StreamEntry<T>;
+
+  /**
+   * Constructs a reader for the stream.
+   *
+   * @param redis_client Connected Redis client.
+   * @param key Redis stream key.
+   * @param last_id Id after which to start reading. "0" reads the stream from
+   *                the beginning, and "$" reads entries added after
+   *                construction.
+   */
+  RedisStreamReader(RedisClient& redis_client, const std::string& key,
+                    const std::string& last_id = "$")
+      : redis_client_(redis_client), key_(key), last_id_(last_id) {
+    if (last_id_ != "$") return;
+
+    // Resolve "$" to the current last entry so that entries added between
+    // reads are not skipped.
+    std::future<std::vector<RedisClient::StreamEntry<std::string>>>
+        fut_last = redis_client_.xrevrange<std::string>(key_, "+", "-", 1);
+    redis_client_.commit();
+    const std::vector<RedisClient::StreamEntry<std::string>> last =
+        fut_last.get();
+    last_id_ = last.empty() ? "0" : last.front().id;
+  }
+
+  /**
+   * @return Redis stream key.
+   */
+  const std::string& key() const { return key_; }
+
+  /**
+   * @return Id of the last entry read.
+   */
+  const std::string& last_id() const { return last_id_; }
+
+  /**
+   * Reads the next batch of entries.
+   *
+   * @param count Maximum number of entries, or 0 for all available entries.
+   * @param block Time to wait for new entries if none are available. Zero
+   *              returns immediately and std::chrono::milliseconds::max()
+   *              waits indefinitely.
+   * @return Entries in increasing id order, or an empty vector if the timeout
+   *         expired.
+   */
+  std::vector<Entry> Read(
+      size_t count = 0,
+      std::chrono::milliseconds block = std::chrono::milliseconds::zero()) {
+    std::vector<Entry> entries =
+        redis_client_.sync_xread<T>(key_, last_id_, count, block);
+    if (!entries.empty()) last_id_ = entries.back().id;
+    return entries;
+  }
+
+ private:
+  RedisClient& redis_client_;
+  std::string key_;
+  std::string last_id_;
+};
+
+}  // namespace ctrl_utils
+
+#endif  // CTRL_UTILS_REDIS_STREAM_H_
@@ -0,0 +1,233 @@
+/**
+ * shared_memory.h
+ *
+ * Copyright 2026. All Rights Reserved.
+ *
+ * Created: October 17, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef CTRL_UTILS_SHARED_MEMORY_H_
+#define CTRL_UTILS_SHARED_MEMORY_H_
+
+#include <fcntl.h>     // O_CREAT, O_EXCL, O_RDONLY, O_RDWR
+#include <sys/mman.h>  // mmap, munmap, shm_open, shm_unlink
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close, ftruncate
+
+#include <atomic>     // std::atomic, std::atomic_thread_fence
+#include <cerrno>     // errno
+#include <chrono>     // std::chrono
+#include <cstdint>    // uint64_t
+#include <cstring>    // std::memcpy, std::strerror
+#include <stdexcept>  // std::runtime_error
+#include <string>     // std::string
+#include <thread>     // std::this_thread
+#include <utility>    // std::exchange
+
+namespace ctrl_utils {
+
+/**
+ * POSIX shared-memory segment holding a single variable-size value.
+ *
+ * The value is guarded by a sequence lock: the writer never blocks, and
+ * readers retry if the value changed while they were copying it. One process
+ * creates and owns the segment and is its only writer. Any number of
+ * processes on the same host can open it for reading.
+ *
+ * __Example__
+ * ~~~~~~~~~~ {.cc}
+ * // Writer process.
+ * ctrl_utils::SharedMemorySegment segment("/camera_depth", 640 * 480 * 4);
+ * segment.Write(img.data, img.total() * img.elemSize());
+ *
+ * // Reader process.
+ * ctrl_utils::SharedMemorySegment segment("/camera_depth");
+ * std::string buffer;
+ * segment.Read(buffer);
+ * ~~~~~~~~~~
+ */
+class SharedMemorySegment {
+ public:
+  /**
+   * Creates a new segment for writing. The segment is unlinked when this
+   * object is destroyed.
+   *
+   * @param name POSIX shared-memory name starting with '/'.
+   * @param capacity Maximum value size in bytes.
+   */
+  SharedMemorySegment(const std::string& name, size_t capacity)
+      : name_(name), is_owner_(true) {
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) throw Error("Failed to create");
+    mapped_size_ = sizeof(Header) + capacity;
+    if (ftruncate(fd, mapped_size_) != 0) {
+      const std::runtime_error error = Error("Failed to allocate");
+      close(fd);
+      shm_unlink(name.c_str());
+      throw error;
+    }
+    Map(fd, PROT_READ | PROT_WRITE);
+    header_->capacity = capacity;
+  }
+
+  /**
+   * Opens an existing segment for reading.
+   *
+   * @param name POSIX shared-memory name starting with '/'.
+   */
+  explicit SharedMemorySegment(const std::string& name)
+      : name_(name), is_owner_(false) {
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) throw Error("Failed to open");
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(Header)) {
+      const std::runtime_error error = Error("Invalid");
+      close(fd);
+      throw error;
+    }
+    mapped_size_ = st.st_size;
+    Map(fd, PROT_READ);
+  }
+
+  SharedMemorySegment(SharedMemorySegment&& other) noexcept
+      : name_(std::move(other.name_)),
+        is_owner_(std::exchange(other.is_owner_, false)),
+        mapped_size_(std::exchange(other.mapped_size_, 0)),
+        header_(std::exchange(other.header_, nullptr)) {}
+
+  SharedMemorySegment(const SharedMemorySegment&) = delete;
+  SharedMemorySegment& operator=(const SharedMemorySegment&) = delete;
+  SharedMemorySegment& operator=(SharedMemorySegment&&) = delete;
+
+  ~SharedMemorySegment() {
+    if (header_ != nullptr) munmap(header_, mapped_size_);
+    if (is_owner_) shm_unlink(name_.c_str());
+  }
+
+  /**
+   * @return POSIX shared-memory name.
+   */
+  const std::string& name() const { return name_; }
+
+  /**
+   * @return Maximum value size in bytes.
+   */
+  size_t capacity() const { return header_->capacity; }
+
+  /**
+   * Writes the value. Only the creator of the segment may write.
+   *
+   * @param data Value bytes.
+   * @param size Value size, at most capacity().
+   * @return Sequence number of the new value.
+   */
+  uint64_t Write(const char* data, size_t size) {
+    if (!is_owner_ || size > header_->capacity) {
+      throw std::runtime_error("SharedMemorySegment::Write(): Cannot write " +
+                               std::to_string(size) + " bytes to " + name_ +
+                               ".");
+    }
+    const uint64_t seq = header_->seq.load(std::memory_order_relaxed);
+    header_->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->size.store(size, std::memory_order_relaxed);
+    std::memcpy(Data(), data, size);
+    header_->seq.store(seq + 2, std::memory_order_release);
+    return seq + 2;
+  }
+
+  /**
+   * Copies a consistent snapshot of the value.
+   *
+   * Reads that overlap a write spin briefly and then yield to the writer. A
+   * writer that exits in the middle of a write leaves the segment
+   * inconsistent, so the read gives up after the timeout.
+   *
+   * @param str Output buffer. Its capacity is reused across reads.
+   * @param timeout Maximum time to wait for a consistent value.
+   * @return Sequence number of the value.
+   */
+  uint64_t Read(std::string& str, std::chrono::nanoseconds timeout =
+                                      kDefaultReadTimeout) const {
+    std::chrono::steady_clock::time_point deadline;
+    for (size_t num_attempts = 0;; num_attempts++) {
+      uint64_t seq;
+      if (TryRead(str, seq)) return seq;
+
+      if (num_attempts == 0) {
+        deadline = std::chrono::steady_clock::now() + timeout;
+      } else if (num_attempts >= kNumSpins) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+          throw std::runtime_error(
+              "SharedMemorySegment::Read(): Timed out waiting for a "
+              "consistent value in " +
+              name_ + ". The writer may have exited during a write.");
+        }
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /// Default timeout for Read().
+  static constexpr std::chrono::milliseconds kDefaultReadTimeout{100};
+
+ private:
+  /// Number of retries before Read() starts yielding.
+  static constexpr size_t kNumSpins = 64;
+
+  struct Header {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> size;
+    uint64_t capacity;
+  };
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "Shared-memory sequence lock requires lock-free atomics.");
+
+  std::runtime_error Error(const std::string& message) const {
+    return std::runtime_error("SharedMemorySegment(): " + message +
+                              " shared memory " + name_ + " (" +
+                              std::strerror(errno) + ").");
+  }
+
+  void Map(int fd, int prot) {
+    void* ptr = mmap(nullptr, mapped_size_, prot, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+      const std::runtime_error error = Error("Failed to map");
+      close(fd);
+      if (is_owner_) shm_unlink(name_.c_str());
+      throw error;
+    }
+    close(fd);
+    header_ = static_cast<Header*>(ptr);
+  }
+
+  /**
+   * Attempts to copy the value. Fails if a write is in progress or overlaps
+   * the copy.
+   */
+  bool TryRead(std::string& str, uint64_t& seq) const {
+    seq = header_->seq.load(std::memory_order_acquire);
+    if (seq % 2 != 0) return false;  // Write in progress.
+
+    const size_t size = header_->size.load(std::memory_order_relaxed);
+    if (size > mapped_size_ - sizeof(Header)) return false;
+    str.resize(size);
+    std::memcpy(&str[0], Data(), size);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header_->seq.load(std::memory_order_relaxed) == seq;
+  }
+
+  char* Data() const { return reinterpret_cast<char*>(header_ + 1); }
+
+  std::string name_;
+  bool is_owner_;
+  size_t mapped_size_ = 0;
+  Header* header_ = nullptr;
+};
+
+}  // namespace ctrl_utils
+
+#endif  // CTRL_UTILS_SHARED_MEMORY_H_
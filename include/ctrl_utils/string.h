@@ -10,16 +10,130 @@
 #ifndef CTRL_UTILS_STRING_H_
 #define CTRL_UTILS_STRING_H_
 
-#include <sstream>  // std::string
-#include <string>   // std::stringstream
+// The codecs take std::string_view. CMake builds get C++17 from the
+// ctrl_utils target.
+#if __cplusplus < 201703L
+#error "ctrl_utils/string.h requires C++17."
+#endif  // __cplusplus < 201703L
+
+#include <istream>      // std::istream
+#include <sstream>      // std::stringstream
+#include <streambuf>    // std::streambuf
+#include <string>       // std::string
+#include <string_view>  // std::string_view
+#include <type_traits>  // std::is_arithmetic, std::is_same, std::void_t
+#include <utility>      // std::declval, std::swap
+
+#if __cplusplus >= 201703L && __has_include(<charconv>)
+#include <charconv>      // std::from_chars, std::to_chars
+#include <system_error>  // std::errc
+#endif  // __cplusplus >= 201703L && __has_include(<charconv>)
 
 namespace ctrl_utils {
 
+namespace string_internal {
+
+/**
+ * Whether the type is converted with std::to_chars and std::from_chars.
+ *
+ * Characters and bools are excluded so that they keep their stream formats.
+ */
+template <typename T>
+struct IsCharconv
+    : std::integral_constant<
+          bool,
+#ifdef __cpp_lib_to_chars
+          std::is_arithmetic<T>::value && !std::is_same<T, bool>::value &&
+              !std::is_same<T, char>::value &&
+              !std::is_same<T, signed char>::value &&
+              !std::is_same<T, unsigned char>::value &&
+              !std::is_same<T, wchar_t>::value &&
+              !std::is_same<T, char16_t>::value &&
+              !std::is_same<T, char32_t>::value
+#else   // __cpp_lib_to_chars
+          false
+#endif  // __cpp_lib_to_chars
+          > {
+};
+
+// Large enough for the shortest representation of any arithmetic type.
+constexpr size_t kMaxCharconvSize = 64;
+
+/**
+ * Whether the type can be extracted from any std::istream, rather than only
+ * from a std::stringstream.
+ */
+template <typename T, typename = void>
+struct IsIstreamExtractable : std::false_type {};
+
+template <typename T>
+struct IsIstreamExtractable<
+    T, std::void_t<decltype(std::declval<std::istream&>() >>
+                            std::declval<T&>())>> : std::true_type {};
+
+}  // namespace string_internal
+
+/**
+ * Input stream that reads a std::string_view in place.
+ *
+ * Unlike std::stringstream, the string is not copied, so the view must outlive
+ * the stream.
+ */
+class StringViewStream : public std::istream {
+ public:
+  explicit StringViewStream(std::string_view str)
+      : std::istream(nullptr), buffer_(str) {
+    rdbuf(&buffer_);
+  }
+
+ private:
+  class Buffer : public std::streambuf {
+   public:
+    explicit Buffer(std::string_view str) {
+      // The get area is never written to.
+      char* data = const_cast<char*>(str.data());
+      setg(data, data, data + str.size());
+    }
+
+   protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override {
+      if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+      char* base = dir == std::ios_base::beg   ? eback()
+                   : dir == std::ios_base::cur ? gptr()
+                                               : egptr();
+      if (off < eback() - base || off > egptr() - base) {
+        return pos_type(off_type(-1));
+      }
+      setg(eback(), base + off, egptr());
+      return pos_type(gptr() - eback());
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+      return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+  };
+
+  Buffer buffer_;
+};
+
 /**
  * Converts the value to a string using stringstream.
+ *
+ * Arithmetic types are converted with std::to_chars if the standard library
+ * supports it, which gives the shortest string that converts back to the same
+ * value.
  */
 template <typename T>
 inline std::string ToString(const T& value) {
+#ifdef __cpp_lib_to_chars
+  if constexpr (string_internal::IsCharconv<T>::value) {
+    char buffer[string_internal::kMaxCharconvSize];
+    const std::to_chars_result result =
+        std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, result.ptr);
+  }
+#endif  // __cpp_lib_to_chars
   std::stringstream ss;
   ss << value;
   return ss.str();
@@ -38,23 +152,67 @@ inline std::string ToString(const std::string& value) {
  */
 template <typename T>
 inline void ToString(std::string& str, const T& value) {
+#ifdef __cpp_lib_to_chars
+  if constexpr (string_internal::IsCharconv<T>::value) {
+    char buffer[string_internal::kMaxCharconvSize];
+    const std::to_chars_result result =
+        std::to_chars(buffer, buffer + sizeof(buffer), value);
+    str.assign(buffer, result.ptr);
+    return;
+  }
+#endif  // __cpp_lib_to_chars
   str = ToString(value);
 }
 
+/**
+ * Appends the value to the string, in the same format as ToString().
+ */
+template <typename T>
+inline void AppendString(std::string& str, const T& value) {
+#ifdef __cpp_lib_to_chars
+  if constexpr (string_internal::IsCharconv<T>::value) {
+    char buffer[string_internal::kMaxCharconvSize];
+    const std::to_chars_result result =
+        std::to_chars(buffer, buffer + sizeof(buffer), value);
+    str.append(buffer, result.ptr);
+    return;
+  }
+#endif  // __cpp_lib_to_chars
+  str += ToString(value);
+}
+
 /**
  * Converts the string to a value using stringstream.
+ *
+ * Arithmetic types are parsed with std::from_chars if the standard library
+ * supports it. Strings that std::from_chars rejects, such as those with
+ * leading whitespace or a '+' sign, fall back to stringstream. Types that can
+ * be extracted from any std::istream read the string in place with
+ * StringViewStream, and only types that require a std::stringstream copy it.
  */
 template <typename T>
-inline void FromString(const std::string& str, T& value) {
-  std::stringstream ss(str);
-  ss >> value;
+inline void FromString(std::string_view str, T& value) {
+#ifdef __cpp_lib_to_chars
+  if constexpr (string_internal::IsCharconv<T>::value) {
+    const std::from_chars_result result =
+        std::from_chars(str.data(), str.data() + str.size(), value);
+    if (result.ec == std::errc()) return;
+  }
+#endif  // __cpp_lib_to_chars
+  if constexpr (string_internal::IsIstreamExtractable<T>::value) {
+    StringViewStream ss(str);
+    ss >> value;
+  } else {
+    std::stringstream ss{std::string(str)};
+    ss >> value;
+  }
 }
 
 /**
  * Converts the string to a value using stringstream.
  */
 template <typename T>
-inline T FromString(const std::string& str) {
+inline T FromString(std::string_view str) {
   T value;
   FromString(str, value);
   return value;
@@ -64,30 +222,106 @@ inline T FromString(const std::string& str) {
  * Template specialization for strings.
  */
 template <>
-inline void FromString(const std::string& str, std::string& value) {
-  value = str;
+inline void FromString(std::string_view str, std::string& value) {
+  value.assign(str.data(), str.size());
 }
 
-#if __cplusplus >= 201703L
-}  // namespace
-
-#include <string_view>
+/**
+ * Template specialization for string views. The value refers to the memory of
+ * the input string.
+ */
+template <>
+inline void FromString(std::string_view str, std::string_view& value) {
+  value = str;
+}
 
-namespace ctrl_utils {
+namespace string_internal {
 
-template <typename T>
-inline T FromString(const std::string_view& str) {
-  T value;
-  FromString(std::string{str}, value);
-  return value;
+/**
+ * Matches one character against the pattern element at idx_pattern, which is
+ * not '*'.
+ *
+ * @param idx_next Output index past the element.
+ */
+inline bool MatchGlobChar(const std::string& pattern, size_t idx_pattern,
+                          char c, size_t& idx_next) {
+  const size_t size = pattern.size();
+  switch (pattern[idx_pattern]) {
+    case '?':
+      idx_next = idx_pattern + 1;
+      return true;
+    case '\\':
+      // A trailing backslash matches itself.
+      if (idx_pattern + 1 < size) ++idx_pattern;
+      idx_next = idx_pattern + 1;
+      return pattern[idx_pattern] == c;
+    case '[': {
+      size_t idx = idx_pattern + 1;
+      const bool is_negated = idx < size && pattern[idx] == '^';
+      if (is_negated) ++idx;
+      bool is_match = false;
+      // An unterminated class extends to the end of the pattern.
+      for (; idx < size && pattern[idx] != ']'; ++idx) {
+        if (pattern[idx] == '\\' && idx + 1 < size) {
+          ++idx;
+          if (pattern[idx] == c) is_match = true;
+        } else if (idx + 2 < size && pattern[idx + 1] == '-') {
+          char start = pattern[idx];
+          char end = pattern[idx + 2];
+          if (start > end) std::swap(start, end);
+          if (start <= c && c <= end) is_match = true;
+          idx += 2;
+        } else if (pattern[idx] == c) {
+          is_match = true;
+        }
+      }
+      idx_next = idx < size ? idx + 1 : size;
+      return is_match != is_negated;
+    }
+    default:
+      idx_next = idx_pattern + 1;
+      return pattern[idx_pattern] == c;
+  }
 }
 
-template <>
-inline void FromString(const std::string& str, std::string_view& value) {
-  value = str;
-}
+}  // namespace string_internal
 
-#endif  // __cplusplus >= 201703L
+/**
+ * Matches the string against a Redis glob pattern.
+ *
+ * '*' matches any sequence of characters, '?' matches any single character,
+ * "[abc]", "[^abc]", and "[a-z]" match one character in, not in, or within the
+ * range of the class, and '\\' escapes the next character. Matching is
+ * case-sensitive, as with the Redis KEYS, SCAN, and PSUBSCRIBE patterns.
+ */
+inline bool MatchGlob(const std::string& pattern, const std::string& str) {
+  size_t idx_pattern = 0;
+  size_t idx_str = 0;
+  size_t idx_star = std::string::npos;
+  size_t idx_star_str = 0;
+  while (idx_str < str.size()) {
+    size_t idx_next;
+    if (idx_pattern < pattern.size() && pattern[idx_pattern] == '*') {
+      // Match the empty sequence first and backtrack if necessary.
+      idx_star = idx_pattern++;
+      idx_star_str = idx_str;
+    } else if (idx_pattern < pattern.size() &&
+               string_internal::MatchGlobChar(pattern, idx_pattern,
+                                              str[idx_str], idx_next)) {
+      idx_pattern = idx_next;
+      ++idx_str;
+    } else if (idx_star != std::string::npos) {
+      idx_pattern = idx_star + 1;
+      idx_str = ++idx_star_str;
+    } else {
+      return false;
+    }
+  }
+  while (idx_pattern < pattern.size() && pattern[idx_pattern] == '*') {
+    ++idx_pattern;
+  }
+  return idx_pattern == pattern.size();
+}
 
 inline std::ostream& bold(std::ostream& os) { return os << "\e[1m"; }
 inline std::ostream& underline(std::ostream& os) { return os << "\e[4m"; }
@@ -12,6 +12,7 @@
 
 #include <ctrl_utils/atomic_queue.h>
 
+#include <atomic>      // std::atomic
 #include <functional>  // std::function
 #include <future>      // std::future, std::promise
 #include <thread>      // std::thread
@@ -114,15 +115,15 @@ class ThreadPool {
 
   AtomicQueue<std::pair<std::function<T()>, Promise>> jobs_;
 
-  std::sig_atomic_t terminate_ = false;
+  std::atomic<bool> terminate_ = false;
 };
 
 /**
  * Executes the job and sets the promised value to void.
  */
 template <>
-void ThreadPool<void>::ExecuteJob(Promise& promise,
-                                  std::function<void()>& job) {
+inline void ThreadPool<void>::ExecuteJob(Promise& promise,
+                                         std::function<void()>& job) {
   job();
   promise->set_value();
 }
@@ -19,8 +19,15 @@
 namespace ctrl_utils {
 
 template <>
-inline YAML::Node FromString(const std::string& str) {
-  return YAML::Load(str);
+inline void FromString(std::string_view str, YAML::Node& value) {
+  StringViewStream ss(str);
+  value = YAML::Load(ss);
+}
+
+template <>
+inline YAML::Node FromString(std::string_view str) {
+  StringViewStream ss(str);
+  return YAML::Load(ss);
 }
 
 }  // namespace ctrl_utils